@@ -0,0 +1,136 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace workerPool {
+
+namespace {
+
+// more threads than this rarely pay off for the game's per tick work
+const int kThreadsMax = 7;
+
+struct Pool {
+    std::mutex mutex;
+    std::condition_variable started;
+    std::condition_variable finished;
+    std::vector< std::thread > threads;
+
+    // the current run, written under the mutex
+    Task * task = nullptr;
+    void * context = nullptr;
+    int partCount = 0;
+    unsigned generation = 0;
+    bool stopping = false;
+
+    std::atomic< int > nextPart{ 0 };
+
+    // threads that haven't finished the current run yet
+    int running = 0;
+
+    Pool();
+    ~Pool();
+};
+
+void drain( Pool & pool, Task * task, void * context, int partCount ) {
+    for ( int part = pool.nextPart++; part < partCount;
+          part = pool.nextPart++ ) {
+        task( context, part );
+    }
+}
+
+void work( Pool & pool ) {
+    std::unique_lock< std::mutex > lock( pool.mutex );
+
+    // from before the first run, a thread that starts late still has to
+    // take part in the runs it missed the start of
+    unsigned seen = 0;
+
+    while ( true ) {
+        pool.started.wait(
+            lock, [ & ] { return pool.stopping || pool.generation != seen; } );
+        if ( pool.stopping ) {
+            return;
+        }
+
+        seen = pool.generation;
+        Task * task = pool.task;
+        void * context = pool.context;
+        int partCount = pool.partCount;
+
+        lock.unlock();
+        drain( pool, task, context, partCount );
+        lock.lock();
+
+        // every thread checks in, so none is left holding this run's parts
+        // when the next one starts
+        if ( --pool.running == 0 ) {
+            pool.finished.notify_one();
+        }
+    }
+}
+
+Pool::Pool() {
+    int count = (int) std::thread::hardware_concurrency() - 1;
+    count = std::clamp( count, 0, kThreadsMax );
+
+    for ( int i = 0; i < count; i++ ) {
+        threads.emplace_back( work, std::ref( *this ) );
+    }
+}
+
+Pool::~Pool() {
+    {
+        std::lock_guard< std::mutex > lock( mutex );
+        stopping = true;
+    }
+    started.notify_all();
+
+    for ( std::thread & thread : threads ) {
+        thread.join();
+    }
+}
+
+Pool & pool() {
+    static Pool pool;
+    return pool;
+}
+
+} // namespace
+
+int threadCount() {
+    return (int) pool().threads.size();
+}
+
+void run( int partCount, Task * task, void * context ) {
+    Pool & p = pool();
+
+    if ( partCount <= 1 || p.threads.empty() ) {
+        for ( int part = 0; part < partCount; part++ ) {
+            task( context, part );
+        }
+        return;
+    }
+
+    {
+        std::lock_guard< std::mutex > lock( p.mutex );
+        p.task = task;
+        p.context = context;
+        p.partCount = partCount;
+        p.nextPart = 0;
+        p.running = (int) p.threads.size();
+        p.generation++;
+    }
+    p.started.notify_all();
+
+    drain( p, task, context, partCount );
+
+    std::unique_lock< std::mutex > lock( p.mutex );
+    p.finished.wait( lock, [ & ] { return p.running == 0; } );
+}
+
+} // namespace workerPool
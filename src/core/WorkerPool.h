@@ -0,0 +1,30 @@
+#pragma once
+
+#include <type_traits>
+
+namespace workerPool {
+
+using Task = void( void * context, int part );
+
+/// Threads run parts on besides the calling one. Zero on a single core.
+int threadCount();
+
+/// Calls task( context, part ) for every part in [ 0, partCount ) on the
+/// pool's threads and the calling one, returns once all parts are done. Parts
+/// may run in any order and on any thread. One run at a time, and parts
+/// must not start runs of their own.
+///
+/// The threads live here in core and only run game code inside run, so the
+/// game library can be reloaded between ticks.
+void run( int partCount, Task * task, void * context );
+
+/// Calls f( part ) for every part, see run above
+template < typename F > void run( int partCount, F && f ) {
+    using Function = std::remove_reference_t< F >;
+    auto call = []( void * context, int part ) {
+        ( *(Function *) context )( part );
+    };
+    run( partCount, call, (void *) &f );
+}
+
+} // namespace workerPool
@@ -1,41 +1,230 @@
 #pragma once
 
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace astar {
-using Index = long;
 
-struct Node {
-    using Id = long;
+/// A* over any graph with hashable node ids. Nodes are added to a table as
+/// the search reaches them and found again through a hash index. The open set
+/// is a pairing heap threaded through the table, so the search never scans or
+/// sorts it.
+template < typename Id > struct Graph {
+    using Index = long;
 
-    Id id;
-    Index parent;
+    struct Node {
+        Id id;
+        Index parent; // -1 for the start
 
-    int h;
-    int g;
-    int f;
-};
+        int g;
+        int f;
+        bool closed;
 
-struct State {
+        // pairing heap links, prev is the parent for a first child and the
+        // left sibling otherwise
+        Index child;
+        Index sibling;
+        Index prev;
+    };
 
-    std::vector< Node > nodes; // TODO: upgrade to hash map?
-    std::vector< Index > open; // TODO: upgrade to min heap
+    std::vector< Node > nodes;
+    std::unordered_map< Id, Index > index;
 
-    Index root; // current node (end of path)
-};
+    Index heapRoot = -1;
+    std::vector< Index > heapScratch;
 
-struct Path {
-    std::vector< Node::Id > nodes;
+    // nodes expanded by the last search
+    int expansions = 0;
 };
 
-void init( State & state, Node::Id start, int heuristic );
+namespace detail {
+
+template < typename Id >
+bool before( const Graph< Id > & graph, long a, long b ) {
+    const auto & na = graph.nodes[ a ];
+    const auto & nb = graph.nodes[ b ];
+
+    // on ties the deeper node is closer to the goal
+    return na.f < nb.f || ( na.f == nb.f && na.g > nb.g );
+}
+
+/// Melds two heaps, the root that goes first keeps the other as first child
+template < typename Id > long meld( Graph< Id > & graph, long a, long b ) {
+    if ( a < 0 ) {
+        return b;
+    }
+    if ( b < 0 ) {
+        return a;
+    }
+    if ( before( graph, b, a ) ) {
+        std::swap( a, b );
+    }
+
+    auto & root = graph.nodes[ a ];
+    auto & child = graph.nodes[ b ];
+    child.prev = a;
+    child.sibling = root.child;
+    if ( root.child >= 0 ) {
+        graph.nodes[ root.child ].prev = b;
+    }
+    root.child = b;
+
+    return a;
+}
+
+template < typename Id > void push( Graph< Id > & graph, long i ) {
+    auto & node = graph.nodes[ i ];
+    node.child = -1;
+    node.sibling = -1;
+    node.prev = -1;
+    graph.heapRoot = meld( graph, graph.heapRoot, i );
+}
+
+/// Cuts a node whose f went down out of its parent and melds it back in
+template < typename Id > void decrease( Graph< Id > & graph, long i ) {
+    if ( i == graph.heapRoot ) {
+        return;
+    }
+
+    auto & node = graph.nodes[ i ];
+    auto & prev = graph.nodes[ node.prev ];
+    if ( prev.child == i ) {
+        prev.child = node.sibling;
+    } else {
+        prev.sibling = node.sibling;
+    }
+    if ( node.sibling >= 0 ) {
+        graph.nodes[ node.sibling ].prev = node.prev;
+    }
+
+    node.sibling = -1;
+    node.prev = -1;
+    graph.heapRoot = meld( graph, graph.heapRoot, i );
+}
+
+/// Removes the root, its children are melded in pairs left to right and the
+/// pairs right to left
+template < typename Id > long pop( Graph< Id > & graph ) {
+    long top = graph.heapRoot;
+    std::vector< long > & pairs = graph.heapScratch;
+    pairs.clear();
+
+    long child = graph.nodes[ top ].child;
+    while ( child >= 0 ) {
+        long a = child;
+        long b = graph.nodes[ a ].sibling;
+        child = b >= 0 ? graph.nodes[ b ].sibling : -1;
+
+        graph.nodes[ a ].sibling = -1;
+        graph.nodes[ a ].prev = -1;
+        if ( b >= 0 ) {
+            graph.nodes[ b ].sibling = -1;
+            graph.nodes[ b ].prev = -1;
+        }
+
+        pairs.push_back( meld( graph, a, b ) );
+    }
+
+    long root = -1;
+    for ( size_t i = pairs.size(); i-- > 0; ) {
+        root = meld( graph, pairs[ i ], root );
+    }
+
+    graph.nodes[ top ].child = -1;
+    graph.heapRoot = root;
+
+    return top;
+}
+
+} // namespace detail
+
+/// Searches from start until end is expanded. neighbors( id, visit ) calls
+/// visit( neighborId, distance ) for every edge out of id, heuristic( id )
+/// must not overestimate the cost from id to end. Returns false if end can't
+/// be reached, the memory of graph is reused between searches.
+template < typename Id, typename Neighbors, typename Heuristic >
+bool search( Graph< Id > & graph, Id start, Id end, Neighbors && neighbors,
+             Heuristic && heuristic ) {
+    using Index = typename Graph< Id >::Index;
+
+    graph.nodes.clear();
+    graph.index.clear();
+    graph.heapRoot = -1;
+    graph.expansions = 0;
+
+    auto addNode = [ & ]( Id id, Index parent, int g ) {
+        Index i = (Index) graph.nodes.size();
+        graph.nodes.push_back( typename Graph< Id >::Node{
+            id, parent, g, g + heuristic( id ), false, -1, -1, -1 } );
+        graph.index.emplace( id, i );
+        detail::push( graph, i );
+    };
+
+    addNode( start, -1, 0 );
+
+    Index current = -1;
+    auto visit = [ & ]( Id id, int distance ) {
+        int g = graph.nodes[ current ].g + distance;
+
+        auto it = graph.index.find( id );
+        if ( it == graph.index.end() ) {
+            addNode( id, current, g );
+            return;
+        }
+
+        Index i = it->second;
+        auto & node = graph.nodes[ i ];
+        if ( g >= node.g ) {
+            return;
+        }
+
+        node.f += g - node.g;
+        node.g = g;
+        node.parent = current;
+
+        // only an inconsistent heuristic reopens a node
+        if ( node.closed ) {
+            node.closed = false;
+            detail::push( graph, i );
+        } else {
+            detail::decrease( graph, i );
+        }
+    };
+
+    while ( graph.heapRoot >= 0 ) {
+        current = detail::pop( graph );
+        graph.nodes[ current ].closed = true;
+        graph.expansions++;
+
+        if ( graph.nodes[ current ].id == end ) {
+            return true;
+        }
+
+        Id id = graph.nodes[ current ].id;
+        neighbors( id, visit );
+    }
+
+    return false;
+}
 
-bool run( State & state );
+/// Ids from the start to end after a search that reached end
+template < typename Id >
+void buildPath( const Graph< Id > & graph, Id end,
+                std::vector< Id > & outPath ) {
+    outPath.clear();
 
-Node::Id root( State & state );
+    auto it = graph.index.find( end );
+    if ( it == graph.index.end() ) {
+        return;
+    }
 
-void addNeighbor( State & state, Node::Id id, int distance, int heuristic );
+    for ( long i = it->second; i != -1; i = graph.nodes[ i ].parent ) {
+        outPath.push_back( graph.nodes[ i ].id );
+    }
 
-Path generatePath( State & state );
+    std::reverse( outPath.begin(), outPath.end() );
+}
 
 } // namespace astar
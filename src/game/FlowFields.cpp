@@ -0,0 +1,89 @@
+#include "FlowFields.h"
+
+namespace flowFields {
+
+namespace {
+
+pathGrid::Info fieldInfo( Field & field, grid::Info gridInfo,
+                          const grid::Bitmap & mask ) {
+    pathGrid::Info info;
+    info.gridInfo = gridInfo;
+    info.mask = &mask;
+    info.costs = &field.costs;
+    info.field = &field.field;
+    info.iterationIndex = 0;
+    return info;
+}
+
+bool hasTarget( const Field & field, grid::Coord target ) {
+    return field.target.x == target.x && field.target.y == target.y;
+}
+
+} // namespace
+
+size_t find( Manager & manager, grid::Info gridInfo,
+             const grid::Bitmap & mask, grid::Coord target ) {
+    std::vector< Field > & fields = manager.fields;
+
+    manager.clock++;
+
+    size_t index = manager.lastIndex;
+    if ( index < fields.size() && hasTarget( fields[ index ], target ) ) {
+        fields[ index ].lastUsed = manager.clock;
+        return index;
+    }
+
+    for ( index = 0; index < fields.size(); index++ ) {
+        if ( hasTarget( fields[ index ], target ) ) {
+            fields[ index ].lastUsed = manager.clock;
+            manager.lastIndex = index;
+            return index;
+        }
+    }
+
+    if ( fields.size() < manager.capacity ) {
+        index = fields.size();
+        fields.emplace_back();
+    } else {
+        // evict the least recently used field, its buffers get reused
+        index = 0;
+        for ( size_t i = 1; i < fields.size(); i++ ) {
+            if ( fields[ i ].lastUsed < fields[ index ].lastUsed ) {
+                index = i;
+            }
+        }
+    }
+
+    Field & field = fields[ index ];
+    field.target = target;
+    field.lastUsed = manager.clock;
+    pathGrid::build( fieldInfo( field, gridInfo, mask ), target );
+
+    manager.lastIndex = index;
+    return index;
+}
+
+bool cached( const Manager & manager, grid::Coord target ) {
+    for ( const Field & field : manager.fields ) {
+        if ( hasTarget( field, target ) ) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void update( Manager & manager, grid::Info gridInfo,
+             const grid::Bitmap & mask,
+             const std::vector< size_t > & changedCells ) {
+    for ( Field & field : manager.fields ) {
+        pathGrid::update( fieldInfo( field, gridInfo, mask ), field.target,
+                          changedCells );
+    }
+}
+
+void clear( Manager & manager ) {
+    manager.fields.clear();
+    manager.lastIndex = 0;
+}
+
+} // namespace flowFields
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Grid.h"
+#include "PathGrid.h"
+
+#include <vector>
+
+namespace flowFields {
+
+struct Field {
+    grid::Coord target;
+    std::vector< pathGrid::Cost > costs;
+    std::vector< pathGrid::Vector > field;
+
+    unsigned lastUsed;
+};
+
+/// Converged flow fields toward several targets over one mask. Fields are
+/// built the first time a target is asked for and the least recently used
+/// one is rebuilt for a new target once capacity is reached.
+struct Manager {
+    size_t capacity = 8;
+    unsigned clock = 0;
+
+    std::vector< Field > fields;
+
+    // last looked up field, crowds mostly share targets
+    size_t lastIndex = 0;
+};
+
+/// Index of the field toward target, built on demand. Indices stay valid
+/// until the next find of a target that isn't cached.
+size_t find( Manager & manager, grid::Info gridInfo,
+             const grid::Bitmap & mask, grid::Coord target );
+
+/// Whether the field toward target is built, doesn't count as a use
+bool cached( const Manager & manager, grid::Coord target );
+
+/// Repairs every field after the mask changed at changedCells
+void update( Manager & manager, grid::Info gridInfo,
+             const grid::Bitmap & mask,
+             const std::vector< size_t > & changedCells );
+
+/// Drops every field, for when the grid is resized
+void clear( Manager & manager );
+
+} // namespace flowFields
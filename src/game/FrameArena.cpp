@@ -0,0 +1,124 @@
+#include "FrameArena.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <random>
+
+namespace frameArena {
+
+// blocks are at least this big, so a cold arena doesn't chain tiny ones
+static const size_t kBlockSizeMin = 64 * 1024;
+
+namespace {
+
+/// Offset of the first address at or past used that is aligned to align
+size_t alignedOffset( const std::vector< unsigned char > & block, size_t used,
+                      size_t align ) {
+    uintptr_t base = (uintptr_t) block.data();
+    uintptr_t aligned = ( base + used + align - 1 ) & ~uintptr_t( align - 1 );
+    return aligned - base;
+}
+
+} // namespace
+
+void * allocate( Arena & arena, size_t size, size_t align ) {
+    if ( !arena.blocks.empty() ) {
+        std::vector< unsigned char > & block = arena.blocks.back();
+        size_t offset = alignedOffset( block, arena.used, align );
+        if ( offset + size <= block.size() ) {
+            arena.used = offset + size;
+            return block.data() + offset;
+        }
+    }
+
+    // out of room, chain a block and leave the earlier ones be since their
+    // memory is still in use
+    arena.blocks.emplace_back( std::max( size + align, kBlockSizeMin ) );
+    arena.allocationCount++;
+
+    std::vector< unsigned char > & block = arena.blocks.back();
+    size_t offset = alignedOffset( block, 0, align );
+    arena.used = offset + size;
+    return block.data() + offset;
+}
+
+void reset( Arena & arena ) {
+    if ( arena.blocks.size() > 1 ) {
+        size_t size = 0;
+        for ( const std::vector< unsigned char > & block : arena.blocks ) {
+            size += block.size();
+        }
+
+        arena.blocks.clear();
+        arena.blocks.emplace_back( size );
+        arena.allocationCount++;
+    }
+
+    arena.used = 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+/// One tick of selections like the pathables ticks make: a few lists of
+/// count items, filled with some of them
+void selectionTick( Arena & arena, size_t count, std::mt19937 & rng ) {
+    reset( arena );
+
+    List< float > len = makeList< float >( arena, count );
+    List< uint32_t > running = makeList< uint32_t >( arena, count );
+    List< uint32_t > stopped = makeList< uint32_t >( arena, count );
+    List< uint8_t > flags = makeList< uint8_t >( arena, count );
+    flags.resize( count );
+
+    for ( size_t i = 0; i < count; i++ ) {
+        len.push_back( float( rng() % 100 ) );
+        flags[ i ] = len[ i ] < 50.0f;
+        if ( flags[ i ] ) {
+            stopped.push_back( uint32_t( i ) );
+        } else {
+            running.push_back( uint32_t( i ) );
+        }
+    }
+
+    LOGGER_ASSERT( running.size() + stopped.size() == count );
+}
+
+/// Once a tick of the biggest size ran, ticks up to that size don't allocate
+/// blocks, whether the first one chained blocks or not
+void testWarmTicksDontAllocate() {
+    std::mt19937 rng( 5 );
+    Arena arena;
+
+    // cold: more than one block's worth, so blocks get chained and merged
+    selectionTick( arena, 50000, rng );
+    selectionTick( arena, 50000, rng );
+    size_t allocations = arena.allocationCount;
+    LOGGER_ASSERT( arena.blocks.size() == 1 );
+
+    for ( int tick = 0; tick < 100; tick++ ) {
+        selectionTick( arena, rng() % 50001, rng );
+    }
+
+    LOGGER_ASSERT( arena.allocationCount == allocations );
+}
+
+/// Items of different alignment packed in one block stay aligned
+void testAlignment() {
+    Arena arena;
+    for ( size_t size = 1; size < 40; size++ ) {
+        allocate( arena, size, 1 );
+        void * item = allocate( arena, size, 16 );
+        LOGGER_ASSERT( (uintptr_t) item % 16 == 0 );
+    }
+}
+
+} // namespace
+
+void runTests() {
+    testWarmTicksDontAllocate();
+    testAlignment();
+}
+
+} // namespace frameArena
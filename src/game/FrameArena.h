@@ -0,0 +1,93 @@
+#pragma once
+
+#include "Logging.h"
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace frameArena {
+
+/// Linear allocator for scratch that lives for one tick. Memory is handed out
+/// by bumping an offset and all of it is taken back at once by reset, which
+/// keeps the memory around so a steady tick allocates nothing.
+struct Arena {
+    // the last block is bumped, earlier ones filled up during this tick
+    std::vector< std::vector< unsigned char > > blocks;
+    size_t used = 0;
+
+    // times an arena block had to be allocated, stays flat once the arena is
+    // warm. Only counts the arena's own blocks, not other heap use of a tick.
+    size_t allocationCount = 0;
+};
+
+void * allocate( Arena & arena, size_t size, size_t align );
+
+/// Takes back everything allocated. Blocks chained on this tick are merged
+/// into one big enough for all of it next time.
+void reset( Arena & arena );
+
+/// Fixed capacity array of trivially copyable items in an arena, gone with
+/// the next reset
+template < typename T > struct List {
+    T * items = nullptr;
+    size_t count = 0;
+    size_t capacity = 0;
+
+    void push_back( const T & item ) {
+        LOGGER_ASSERT( count < capacity );
+        items[ count++ ] = item;
+    }
+
+    /// Grows or shrinks to count items, new ones are left uninitialized
+    void resize( size_t newCount ) {
+        LOGGER_ASSERT( newCount <= capacity );
+        count = newCount;
+    }
+
+    size_t size() const {
+        return count;
+    }
+
+    bool empty() const {
+        return count == 0;
+    }
+
+    T & operator[]( size_t i ) {
+        return items[ i ];
+    }
+
+    const T & operator[]( size_t i ) const {
+        return items[ i ];
+    }
+
+    T * begin() {
+        return items;
+    }
+
+    T * end() {
+        return items + count;
+    }
+
+    const T * begin() const {
+        return items;
+    }
+
+    const T * end() const {
+        return items + count;
+    }
+};
+
+template < typename T > List< T > makeList( Arena & arena, size_t capacity ) {
+    static_assert( std::is_trivially_copyable_v< T > &&
+                   std::is_trivially_destructible_v< T > );
+
+    List< T > list;
+    list.items = (T *) allocate( arena, capacity * sizeof( T ), alignof( T ) );
+    list.capacity = capacity;
+    return list;
+}
+
+void runTests();
+
+} // namespace frameArena
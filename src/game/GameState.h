@@ -1,12 +1,23 @@
 #pragma once
 
+#include "FlowFields.h"
+#include "FrameArena.h"
 #include "Graphics.h"
 #include "Grid.h"
 #include "GridAstar.h"
+#include "GridDstar.h"
+#include "Hpa.h"
 #include "Mesh.h"
+#include "PathCache.h"
+#include "PathQuery.h"
+#include "PathStore.h"
 #include "Pool.h"
 #include "Rect.h"
+#include "RectIndex.h"
+#include "Registry.h"
 #include "SharedState.h"
+#include "Soa.h"
+#include "SpatialHash.h"
 #include "Utility.h"
 
 #include <glm/mat4x4.hpp>
@@ -219,7 +230,7 @@ struct Wall {
 };
 
 using index_t = int;
-using id_t = long;
+using id_t = registry::Id;
 
 struct Console {
     std::vector< std::string > lines;
@@ -237,21 +248,23 @@ struct KitchenTypes {
     std::vector< id_t > recipes;
 };
 
-struct Kitchens {
-    std::vector< id_t > ids;
-
-    std::vector< glm::vec2 > positions;
-    std::vector< id_t > types;
+enum KitchenColumn : size_t {
+    kKitchenId,
+    kKitchenPosition,
+    kKitchenType,
 };
 
-struct Tables {
-    std::vector< id_t > ids;
+using Kitchens = soa::Table< id_t, glm::vec2, id_t >;
 
-    std::vector< glm::vec2 > positions;
-    std::vector< int > customerCounts;
-    std::vector< int > states;
+enum TableColumn : size_t {
+    kTableId,
+    kTablePosition,
+    kTableCustomerCount,
+    kTableState,
 };
 
+using Tables = soa::Table< id_t, glm::vec2, int, int >;
+
 struct Recipes {
     std::vector< id_t > ids;
 
@@ -259,44 +272,68 @@ struct Recipes {
     std::vector< int > prices;
 };
 
-struct ChefSkillTable {
-    std::vector< id_t > chefs;
-    std::vector< id_t > recipes;
-
-    std::vector< int > skillLevels;
+enum ChefSkillColumn : size_t {
+    kChefSkillChef,
+    kChefSkillRecipe,
+    kChefSkillLevel,
 };
 
-struct Chefs {
-    std::vector< id_t > ids;
+using ChefSkillTable = soa::Table< id_t, id_t, int >;
 
-    std::vector< id_t > kitchens;
-    std::vector< id_t > recipes;
-    std::vector< id_t > customers;
-    std::vector< int > states;
-    std::vector< float > timers;
+enum ChefColumn : size_t {
+    kChefId,
+    kChefKitchen,
+    kChefRecipe,
+    kChefCustomer,
+    kChefState,
+    kChefTimer,
 };
 
+using Chefs = soa::Table< id_t, id_t, id_t, id_t, int, float >;
+
 struct TargetEntry {
     id_t targeter;
     id_t target;
 };
 
-struct Customers {
-    std::vector< id_t > id;
+enum CustomerColumn : size_t {
+    kCustomerId,
+
+    kCustomerPosition,
+    kCustomerVelocity,
+    kCustomerTarget,
+    kCustomerSubtarget,
 
-    std::vector< glm::vec2 > position;
-    std::vector< glm::vec2 > velocity;
-    std::vector< glm::vec2 > target;
-    std::vector< glm::vec2 > subtarget;
+    kCustomerRepathTimer,
 
-    std::vector< float > repathTimer;
+    // per customer math::xorshift32 state for movement jitter
+    kCustomerRngState,
 
-    std::vector< astar::Path * > path;
-    std::vector< index_t > pathIndex;
+    // spans of TycoonSim::customerPaths
+    kCustomerPath,
+    kCustomerPathIndex,
 
-    std::vector< id_t > orders;
-    std::vector< id_t > tables;
-    std::vector< int > states;
+    // a path query is in flight, its result replaces path when it lands
+    kCustomerAwaitingPath,
+
+    // coarse waypoints from the cluster graph, path covers one leg of it
+    kCustomerRoute,
+    kCustomerRouteIndex,
+
+    kCustomerOrder,
+    kCustomerTable,
+    kCustomerState,
+};
+
+struct Customers {
+    // maps ids to rows of columns, which are swap removed together
+    registry::Registry registry;
+
+    // in CustomerColumn order
+    soa::Table< id_t, glm::vec2, glm::vec2, glm::vec2, glm::vec2, float,
+                uint32_t, pathStore::Handle, index_t, uint8_t,
+                std::vector< grid::Coord >, index_t, id_t, id_t, int >
+        columns;
 };
 
 struct TycoonSimTransient {
@@ -312,8 +349,35 @@ struct TycoonSim {
     KitchenTypes kitchenTypes;
 
     std::vector< id_t > customersAtTarget;
+    std::vector< index_t > removedCustomers;
     std::vector< TargetEntry > customersTargetingTables;
     std::vector< TargetEntry > customersTargetingKitchens;
+
+    // reused by every path query, see allocationCount
+    astar::SearchContext searchContext;
+
+    // customer path queries are queued during a tick and solved off thread
+    // within a per tick budget, finished paths are applied at the start of
+    // the next tick. Queries carry the customer id.
+    pathQuery::Service pathQueries;
+    std::vector< pathQuery::Query > queuedPathQueries;
+    unsigned pendingPathVersion = 0;
+    pathQuery::Batch pathResults;
+
+    // complete customer paths for the current collision grid version
+    pathCache::Cache pathCache;
+
+    // points of every customer path
+    pathStore::Store customerPaths;
+    std::vector< grid::Coord > pathScratch;
+
+    // per tick selections and streams of the pathables ticks, reset at the
+    // start of each. Its allocationCount covers only these, not the other
+    // containers the ticks use.
+    frameArena::Arena scratch;
+
+    // customer positions at the start of the mass pathables tick
+    spatialHash::Hash customerHash;
 };
 
 struct Tycoon {
@@ -363,6 +427,9 @@ struct Tycoon {
 
     std::vector< Rect > walls;
 
+    // broadphase over walls, ids are indices into walls
+    rectIndex::Index wallIndex;
+
     glm::vec2 mousePosition;
 
     std::vector< Rect > selectorButtons;
@@ -374,17 +441,27 @@ struct Tycoon {
     std::vector< grid::Coord > waypoints;
     std::vector< grid::Coord > debugPoints;
 
+    // kept across wall edits so the waypoint path is repaired, not replanned
+    dstar::Planner waypointPlanner;
+
     Console console;
     Humans humans;
 
     TycoonSim tycoonSim;
 
     grid::Info collisionGridInfo;
-    std::vector< int > collisionGridData;
+    grid::Bitmap collisionGridData;
+    unsigned collisionGridVersion = 0;
+    hpa::Graph collisionGraph;
+
+    // flow fields toward customer targets over the collision grid
+    flowFields::Manager flowFields;
+
+    // steer along the interpolated cost slope instead of the 4-bit field
+    bool sampleFieldGradient = false;
 
-    // TODO: this is just for testing path grid stuff
-    std::vector< int > pathGridCosts;
-    std::vector< unsigned char > pathGridField;
+    // push humans apart so a crowd doesn't stack up on one cell
+    bool separateHumans = true;
 
     int money;
     int moneyDisplayed;
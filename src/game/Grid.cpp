@@ -1,5 +1,7 @@
 #include "Grid.h"
 
+#include <cstdlib>
+
 namespace grid {
 
 size_t size( const Info & info ) {
@@ -31,4 +33,85 @@ bool contains( const Info & info, Size x, Size y ) {
     return x >= 0 && y >= 0 && x < info.width && y < info.height;
 }
 
+void appendLine( Coord a, Coord b, std::vector< Coord > & outCells ) {
+    int nx = std::abs( b.x - a.x );
+    int ny = std::abs( b.y - a.y );
+    int sx = b.x > a.x ? 1 : -1;
+    int sy = b.y > a.y ? 1 : -1;
+
+    Coord c = a;
+    outCells.push_back( c );
+
+    for ( int ix = 0, iy = 0; ix < nx || iy < ny; ) {
+        // whether the line leaves the cell through a vertical edge, the
+        // horizontal one or the corner between them
+        long decision = long( 1 + 2 * ix ) * ny - long( 1 + 2 * iy ) * nx;
+
+        if ( decision == 0 ) {
+            c.x += sx;
+            c.y += sy;
+            ix++;
+            iy++;
+        } else if ( decision < 0 ) {
+            c.x += sx;
+            ix++;
+        } else {
+            c.y += sy;
+            iy++;
+        }
+
+        outCells.push_back( c );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static size_t tilesWide( const Info & info ) {
+    return ( info.width + kTileSize - 1 ) / kTileSize;
+}
+
+static size_t tilesHigh( const Info & info ) {
+    return ( info.height + kTileSize - 1 ) / kTileSize;
+}
+
+void resize( Bitmap & bitmap, Info info ) {
+    bitmap.info = info;
+    bitmap.tiles.assign( tilesWide( info ) * tilesHigh( info ), 0 );
+}
+
+void set( Bitmap & bitmap, Size x, Size y, bool value ) {
+    size_t i = tiledIndex( bitmap.info, x, y );
+    uint64_t bit = uint64_t( 1 ) << ( i % 64 );
+
+    if ( value ) {
+        bitmap.tiles[ i / 64 ] |= bit;
+    } else {
+        bitmap.tiles[ i / 64 ] &= ~bit;
+    }
+}
+
+/// Row y of a tile as 8 bits
+static unsigned tileRowBits( const Bitmap & bitmap, size_t tileX, Size y ) {
+    size_t tile = ( y / kTileSize ) * tilesWide( bitmap.info ) + tileX;
+
+    // the row's cells sit at the x spreads 0, 1, 4, 5, 16, 17, 20, 21
+    uint64_t t = bitmap.tiles[ tile ] >> ( mortonSpread( y ) << 1 );
+    t &= 0x330033;
+    t = ( t | ( t >> 2 ) ) & 0x0f000f;
+    t = ( t | ( t >> 12 ) ) & 0xff;
+    return t;
+}
+
+unsigned rowBits( const Bitmap & bitmap, Size x, Size y ) {
+    size_t tileX = x / kTileSize;
+    unsigned bits = tileRowBits( bitmap, tileX, y );
+
+    int shift = x % kTileSize;
+    if ( shift != 0 && tileX + 1 < tilesWide( bitmap.info ) ) {
+        bits |= tileRowBits( bitmap, tileX + 1, y ) << 8;
+    }
+
+    return ( bits >> shift ) & 0xff;
+}
+
 } // namespace grid
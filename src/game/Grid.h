@@ -1,6 +1,9 @@
 #pragma once
 
 #include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
 
 namespace grid {
 using Size = int;
@@ -28,4 +31,60 @@ bool contains( const Info & info, Coord coord );
 
 bool contains( const Info & info, Size x, Size y );
 
+/// Appends the cells the straight line between the centers of a and b passes
+/// through, in order from a to b. Where the line goes exactly through a
+/// corner it only touches the cells beside it, those are left out the same
+/// way diagonal moves pass between them.
+void appendLine( Coord a, Coord b, std::vector< Coord > & outCells );
+
+////////////////////////////////////////////////////////////////////////////////
+
+// the tiled layout groups cells into 8x8 tiles, Morton order inside a tile,
+// so the cells above and below one are usually on the same cache line
+static const Size kTileSize = 8;
+
+/// Spreads the 3 bits of v to the even bits of a 6-bit Morton code
+inline size_t mortonSpread( Size v ) {
+    size_t m = v & 7;
+    m = ( m | ( m << 2 ) ) & 0x13;
+    m = ( m | ( m << 1 ) ) & 0x15;
+    return m;
+}
+
+/// Only for cells in the grid
+inline size_t tiledIndex( const Info & info, Size x, Size y ) {
+    size_t tilesWide = size_t( info.width + kTileSize - 1 ) >> 3;
+    size_t tile = ( size_t( y ) >> 3 ) * tilesWide + ( size_t( x ) >> 3 );
+    return ( tile << 6 ) | mortonSpread( x ) | ( mortonSpread( y ) << 1 );
+}
+
+inline size_t tiledIndex( const Info & info, Coord coord ) {
+    return tiledIndex( info, coord.x, coord.y );
+}
+
+/// One bit per cell in the tiled layout, set for blocked cells. A tile is
+/// one word, so a whole neighborhood is usually a single load.
+struct Bitmap {
+    Info info;
+    std::vector< uint64_t > tiles;
+};
+
+/// Sizes the bitmap to info with every cell clear
+void resize( Bitmap & bitmap, Info info );
+
+inline bool test( const Bitmap & bitmap, Size x, Size y ) {
+    size_t i = tiledIndex( bitmap.info, x, y );
+    return ( bitmap.tiles[ i / 64 ] >> ( i % 64 ) ) & 1;
+}
+
+inline bool test( const Bitmap & bitmap, Coord coord ) {
+    return test( bitmap, coord.x, coord.y );
+}
+
+void set( Bitmap & bitmap, Size x, Size y, bool value );
+
+/// Cells x to x + 7 of row y as bits 0 to 7, cells past the right edge read
+/// as clear
+unsigned rowBits( const Bitmap & bitmap, Size x, Size y );
+
 } // namespace grid
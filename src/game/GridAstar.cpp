@@ -1,8 +1,10 @@
 #include "GridAstar.h"
 
+#include "Astar.h"
 #include "Logging.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 
 namespace astar {
@@ -40,194 +42,441 @@ int heuristic( grid::Coord node, grid::Coord end ) {
     return octileHeuristic( node, end );
 }
 
-Path shortestPath( grid::Info gridInfo, const std::vector< int > & gridData,
-                   grid::Coord start, grid::Coord end, int iterationMax ) {
-
-    // swap the start and end so we don't need to reverse the path on
-    // reconstruction
-    // std::swap( start, end );
+namespace {
 
-    size_t startIndex = grid::index( gridInfo, start );
-    size_t endIndex = grid::index( gridInfo, end );
-    size_t gridSize = gridInfo.width * gridInfo.height;
+enum CellState : unsigned char {
+    kCellUnvisited = 0,
+    kCellOpen,
+    kCellClosed,
+};
 
-    // DEBUG_LOG() << "grid size: " << gridSize << std::endl;
+/// Indexed binary min-heap over the open cells of a search context, with
+/// decrease-key. Ties on score are broken toward the most recently inserted
+/// cell, matching the old linear scan of the open list.
+struct OpenHeap {
+    SearchSide & side;
 
-    std::vector< int > g( gridSize, 0 );
-    std::vector< size_t > parent( gridSize, gridSize );
-    std::vector< size_t > open;
-    std::vector< grid::Coord > coord( gridSize );
+    bool empty() const {
+        return side.open.empty();
+    }
 
-    for ( size_t i = 0; i < gridSize; i++ ) {
-        grid::Coord c;
-        c.x = i % gridInfo.width;
-        c.y = i / gridInfo.width;
-        coord[ i ] = c;
+    size_t top() const {
+        return side.open[ 0 ];
+    }
 
-        // if ( grid::index( gridInfo, c ) != i ) {
-        //     ERROR_LOG() << "AHHHH" << std::endl;
-        // }
+    bool before( size_t a, size_t b ) const {
+        if ( side.scores[ a ] != side.scores[ b ] ) {
+            return side.scores[ a ] < side.scores[ b ];
+        }
+        return side.orders[ a ] > side.orders[ b ];
     }
 
-    open.push_back( grid::index( gridInfo, start ) );
+    void place( size_t i, size_t cell ) {
+        side.open[ i ] = cell;
+        side.heapPositions[ cell ] = i;
+    }
 
-    int watchdog1 = 0;
-    size_t bestCell;
-    while ( !open.empty() ) {
-        // DEBUG_LOG() << "iterate astar" << std::endl;
+    void siftUp( size_t i ) {
+        size_t cell = side.open[ i ];
+        while ( i > 0 ) {
+            size_t up = ( i - 1 ) / 2;
+            if ( !before( cell, side.open[ up ] ) ) {
+                break;
+            }
+            place( i, side.open[ up ] );
+            i = up;
+        }
+        place( i, cell );
+    }
 
-        // find best cell in open
-        size_t bestCellOpenIndex = 0;
-        bestCell = open[ bestCellOpenIndex ];
-        int bestCellScore = g[ bestCell ] + heuristic( coord[ bestCell ], end );
-
-        for ( size_t i = 1; i < std::ssize( open ); i++ ) {
-            size_t cell = open[ i ];
-            int gScore = g[ cell ];
-            int hScore = heuristic( coord[ cell ], end );
-            int score = gScore + hScore;
-
-            // DEBUG_LOG() << "open cell: " << coord[ cell ].x << ", "
-            //             << coord[ cell ].y << " g:" << gScore << " h:" <<
-            //             hScore
-            //             << std::endl;
-
-            if ( score <= bestCellScore ) {
-                bestCellOpenIndex = i;
-                bestCell = cell;
-                bestCellScore = score;
+    void siftDown( size_t i ) {
+        std::vector< size_t > & cells = side.open;
+        size_t cell = cells[ i ];
+        size_t n = cells.size();
+        while ( true ) {
+            size_t child = 2 * i + 1;
+            if ( child >= n ) {
+                break;
+            }
+            if ( child + 1 < n &&
+                 before( cells[ child + 1 ], cells[ child ] ) ) {
+                child++;
             }
+            if ( !before( cells[ child ], cell ) ) {
+                break;
+            }
+            place( i, cells[ child ] );
+            i = child;
+        }
+        place( i, cell );
+    }
+
+    void push( size_t cell, int score ) {
+        side.scores[ cell ] = score;
+        side.orders[ cell ] = side.nextOrder++;
+        side.open.push_back( cell );
+        siftUp( side.open.size() - 1 );
+    }
+
+    void pop() {
+        size_t last = side.open.back();
+        side.open.pop_back();
+        if ( !side.open.empty() ) {
+            place( 0, last );
+            siftDown( 0 );
         }
+    }
+
+    void decrease( size_t cell, int score ) {
+        side.scores[ cell ] = score;
+        siftUp( side.heapPositions[ cell ] );
+    }
+};
 
-        // DEBUG_LOG() << "best open cell: " << coord[ bestCell ].x << ", "
-        //             << coord[ bestCell ].y << " g:" << g[ bestCell ]
-        //             << " h:" << heuristic( coord[ bestCell ], end )
-        //             << std::endl;
+CellState cellState( const SearchContext & context, const SearchSide & side,
+                     size_t cell ) {
+    if ( side.stamps[ cell ] != context.generation ) {
+        return kCellUnvisited;
+    }
+    return CellState( side.cellStates[ cell ] );
+}
 
-        watchdog1++;
-        if ( watchdog1 >= iterationMax ) {
-            // find the best heuristic cell
+void setCellState( const SearchContext & context, SearchSide & side,
+                   size_t cell, CellState s ) {
+    side.stamps[ cell ] = context.generation;
+    side.cellStates[ cell ] = s;
+}
 
-            bestCell = open[ 0 ];
-            for ( size_t i : open ) {
-                if ( heuristic( coord[ i ], end ) <
-                     heuristic( coord[ bestCell ], end ) ) {
-                    bestCell = i;
-                }
+void resizeSide( SearchContext & context, SearchSide & side,
+                 size_t gridSize ) {
+    if ( side.stamps.size() == gridSize ) {
+        return;
+    }
+
+    side.stamps.assign( gridSize, 0 );
+    side.cellStates.assign( gridSize, kCellUnvisited );
+    side.g.assign( gridSize, 0 );
+    side.parents.assign( gridSize, gridSize );
+    side.scores.assign( gridSize, 0 );
+    side.orders.assign( gridSize, 0 );
+    side.heapPositions.assign( gridSize, 0 );
+    side.open.reserve( gridSize );
+    context.allocationCount++;
+}
+
+/// Sizes the context for the grid and starts a new generation
+void beginSearch( SearchContext & context, size_t gridSize,
+                  bool bidirectional ) {
+    if ( context.gridSize != gridSize ) {
+        context.gridSize = gridSize;
+        context.scratch.reserve( gridSize );
+        context.generation = 0;
+    }
+
+    resizeSide( context, context.forward, gridSize );
+    if ( bidirectional ) {
+        resizeSide( context, context.backward, gridSize );
+    }
+
+    context.generation++;
+
+    // stamps wrapped around, old stamps could alias the new generation
+    if ( context.generation == 0 ) {
+        for ( SearchSide * side : { &context.forward, &context.backward } ) {
+            std::fill( side->stamps.begin(), side->stamps.end(), 0 );
+        }
+        context.generation = 1;
+    }
+
+    for ( SearchSide * side : { &context.forward, &context.backward } ) {
+        side->open.clear();
+        side->nextOrder = 0;
+    }
+}
+
+bool walkable( grid::Info gridInfo, const grid::Bitmap & gridData, int x,
+               int y ) {
+    return grid::contains( gridInfo, x, y ) && !grid::test( gridData, x, y );
+}
+
+int sign( int x ) {
+    return ( x > 0 ) - ( x < 0 );
+}
+
+/// Steps from coord in direction (dx, dy) until it reaches a jump point: the
+/// end, a cell with a forced neighbor, or (moving diagonally) a cell that
+/// can see a jump point straight ahead. Blocked cells and the grid edge stop
+/// the jump.
+bool jump( grid::Info gridInfo, const grid::Bitmap & gridData,
+           grid::Coord coord, int dx, int dy, grid::Coord end,
+           grid::Coord & outJump ) {
+    auto open = [ & ]( int x, int y ) {
+        return walkable( gridInfo, gridData, x, y );
+    };
+
+    int x = coord.x;
+    int y = coord.y;
+
+    while ( true ) {
+        x += dx;
+        y += dy;
+
+        if ( !open( x, y ) ) {
+            return false;
+        }
+
+        outJump = grid::Coord{ x, y };
+
+        if ( x == end.x && y == end.y ) {
+            return true;
+        }
+
+        if ( dx != 0 && dy != 0 ) {
+            if ( ( open( x - dx, y + dy ) && !open( x - dx, y ) ) ||
+                 ( open( x + dx, y - dy ) && !open( x, y - dy ) ) ) {
+                return true;
             }
 
-            break;
+            grid::Coord unused;
+            if ( jump( gridInfo, gridData, outJump, dx, 0, end, unused ) ||
+                 jump( gridInfo, gridData, outJump, 0, dy, end, unused ) ) {
+                return true;
+            }
+        } else if ( dx != 0 ) {
+            if ( ( open( x + dx, y + 1 ) && !open( x, y + 1 ) ) ||
+                 ( open( x + dx, y - 1 ) && !open( x, y - 1 ) ) ) {
+                return true;
+            }
+        } else {
+            if ( ( open( x + 1, y + dy ) && !open( x + 1, y ) ) ||
+                 ( open( x - 1, y + dy ) && !open( x - 1, y ) ) ) {
+                return true;
+            }
         }
+    }
+}
 
-        open.erase( open.begin() + bestCellOpenIndex );
+/// Directions worth jumping in from a cell reached by moving (dx, dy): the
+/// natural neighbors plus any forced ones. Returns the direction count.
+int prunedDirections( grid::Info gridInfo, const grid::Bitmap & gridData,
+                      grid::Coord c, int dx, int dy, grid::Coord * outDirs ) {
+    auto open = [ & ]( int x, int y ) {
+        return walkable( gridInfo, gridData, x, y );
+    };
 
-        // found the end
-        if ( bestCell == endIndex ) {
+    int n = 0;
+
+    if ( dx != 0 && dy != 0 ) {
+        outDirs[ n++ ] = grid::Coord{ 0, dy };
+        outDirs[ n++ ] = grid::Coord{ dx, 0 };
+        outDirs[ n++ ] = grid::Coord{ dx, dy };
+        if ( !open( c.x - dx, c.y ) ) {
+            outDirs[ n++ ] = grid::Coord{ -dx, dy };
+        }
+        if ( !open( c.x, c.y - dy ) ) {
+            outDirs[ n++ ] = grid::Coord{ dx, -dy };
+        }
+    } else if ( dx != 0 ) {
+        outDirs[ n++ ] = grid::Coord{ dx, 0 };
+        if ( !open( c.x, c.y + 1 ) ) {
+            outDirs[ n++ ] = grid::Coord{ dx, 1 };
+        }
+        if ( !open( c.x, c.y - 1 ) ) {
+            outDirs[ n++ ] = grid::Coord{ dx, -1 };
+        }
+    } else {
+        outDirs[ n++ ] = grid::Coord{ 0, dy };
+        if ( !open( c.x + 1, c.y ) ) {
+            outDirs[ n++ ] = grid::Coord{ 1, dy };
+        }
+        if ( !open( c.x - 1, c.y ) ) {
+            outDirs[ n++ ] = grid::Coord{ -1, dy };
+        }
+    }
+
+    return n;
+}
+
+/// The open cell closest to end, earliest inserted wins ties. For searches
+/// cut short by their iteration cap.
+size_t closestOpenCell( const SearchSide & side, grid::Info gridInfo,
+                        grid::Coord end ) {
+    size_t bestCell = side.open[ 0 ];
+    int bestH = heuristic( grid::coord( gridInfo, bestCell ), end );
+    for ( size_t i : side.open ) {
+        int h = heuristic( grid::coord( gridInfo, i ), end );
+        bool earlier = side.orders[ i ] < side.orders[ bestCell ];
+        if ( h < bestH || ( h == bestH && earlier ) ) {
+            bestCell = i;
+            bestH = h;
+        }
+    }
+    return bestCell;
+}
+
+/// Grows frontiers from start and from end in turns, until neither open set
+/// can beat the cheapest meeting found. Returns the cell to
+/// build the path from: the end when the frontiers met, with the backward
+/// half spliced into the forward parents.
+size_t searchBidirectional( SearchContext & context, grid::Info gridInfo,
+                            const grid::Bitmap & gridData, grid::Coord start,
+                            grid::Coord end, int iterationMax ) {
+    size_t gridSize = context.gridSize;
+    SearchSide * sides[ 2 ] = { &context.forward, &context.backward };
+    size_t roots[ 2 ] = { grid::index( gridInfo, start ),
+                          grid::index( gridInfo, end ) };
+    grid::Coord goals[ 2 ] = { end, start };
+
+    for ( int s = 0; s < 2; s++ ) {
+        SearchSide & side = *sides[ s ];
+        side.g[ roots[ s ] ] = 0;
+        side.parents[ roots[ s ] ] = gridSize;
+        OpenHeap{ side }.push( roots[ s ], heuristic( start, end ) );
+        setCellState( context, side, roots[ s ], kCellOpen );
+    }
+
+    // cheapest start to end path through a cell both sides reached
+    size_t meet = roots[ 0 ] == roots[ 1 ] ? roots[ 0 ] : gridSize;
+    int meetCost = 0;
+
+    int expansions = 0;
+    while ( !context.forward.open.empty() && !context.backward.open.empty() ) {
+        if ( meet != gridSize ) {
+            SearchSide & f = context.forward;
+            SearchSide & b = context.backward;
+            if ( std::max( f.scores[ f.open[ 0 ] ],
+                           b.scores[ b.open[ 0 ] ] ) >= meetCost ) {
+                break;
+            }
+        }
+
+        if ( expansions >= iterationMax ) {
             break;
         }
 
-        // look at neighbors
-        for ( size_t i = 0; i < 8; i++ ) {
-            grid::Coord offset = kNborOffsets[ i ];
-            int weight = kNborWeights[ i ];
+        // take turns, a side filling a dead end can't starve the other
+        int s = expansions % 2;
+        expansions++;
 
-            grid::Coord nborCoord;
-            nborCoord.x = coord[ bestCell ].x + offset.x;
-            nborCoord.y = coord[ bestCell ].y + offset.y;
+        SearchSide & side = *sides[ s ];
+        SearchSide & other = *sides[ 1 - s ];
+        OpenHeap open{ side };
 
-            // weight += randCost( nborCoord );
+        size_t bestCell = open.top();
+        open.pop();
+        setCellState( context, side, bestCell, kCellClosed );
 
-            // out of bounds
-            if ( !grid::contains( gridInfo, nborCoord ) ) {
+        grid::Coord bestCoord = grid::coord( gridInfo, bestCell );
+
+        for ( size_t i = 0; i < 8; i++ ) {
+            grid::Coord nborCoord;
+            nborCoord.x = bestCoord.x + kNborOffsets[ i ].x;
+            nborCoord.y = bestCoord.y + kNborOffsets[ i ].y;
+
+            if ( !grid::contains( gridInfo, nborCoord ) ||
+                 grid::test( gridData, nborCoord ) ) {
                 continue;
             }
 
             size_t nbor = grid::index( gridInfo, nborCoord );
+            if ( nbor == roots[ s ] ) {
+                continue;
+            }
 
-            // ignore start cell (don't want to overwrite parent)
-            if ( nbor == startIndex ) {
+            int newG = side.g[ bestCell ] + kNborWeights[ i ];
+            CellState nborState = cellState( context, side, nbor );
+            if ( nborState != kCellUnvisited && newG >= side.g[ nbor ] ) {
                 continue;
             }
 
-            // skip non solids
-            if ( gridData[ nbor ] != 0 ) {
+            // a cell that can't beat the meeting isn't worth opening
+            int newScore = newG + heuristic( nborCoord, goals[ s ] );
+            if ( meet != gridSize && newScore >= meetCost ) {
                 continue;
             }
 
-            int newG = g[ bestCell ] + weight;
+            side.g[ nbor ] = newG;
+            side.parents[ nbor ] = bestCell;
 
-            if ( parent[ nbor ] == gridSize ) {
-                // unvisited
-                g[ nbor ] = newG;
-                parent[ nbor ] = bestCell;
-                open.push_back( nbor );
+            if ( nborState == kCellOpen ) {
+                open.decrease( nbor, newScore );
             } else {
-                // visited
-
-                if ( newG < g[ nbor ] ) {
-                    auto oldCoord = coord[ parent[ nbor ] ];
-
-                    // DEBUG_LOG() << "cell re-evaluated" << std::endl;
-                    // DEBUG_LOG() << "cell pos " << nborCoord.x << ", "
-                    //             << nborCoord.y << std::endl;
-                    // DEBUG_LOG() << "old g " << g[ nbor ] << std::endl;
-                    // DEBUG_LOG() << "old parent " << oldCoord.x << ", "
-                    //             << oldCoord.y << std::endl;
-                    g[ nbor ] = newG;
-                    parent[ nbor ] = bestCell;
-
-                    auto newCoord = coord[ parent[ nbor ] ];
-                    // DEBUG_LOG() << "new g " << g[ nbor ] << std::endl;
-                    // DEBUG_LOG() << "new parent " << newCoord.x << ", "
-                    //             << newCoord.y << std::endl;
-
-                    // add to open list if not already
-                    if ( std::find( open.begin(), open.end(), nbor ) ==
-                         open.end() ) {
-                        ERROR_LOG() << "closed node re-evaluated!" << std::endl;
-                        open.push_back( nbor );
-                    }
-                }
+                open.push( nbor, newScore );
+                setCellState( context, side, nbor, kCellOpen );
+            }
+
+            if ( cellState( context, other, nbor ) != kCellUnvisited &&
+                 ( meet == gridSize || newG + other.g[ nbor ] < meetCost ) ) {
+                meet = nbor;
+                meetCost = newG + other.g[ nbor ];
             }
         }
     }
 
-    //DEBUG_LOG() << "A* took " << watchdog1 << " iterations" << std::endl;
+    context.expansions = expansions;
 
-    // build path
-    Path path;
+    if ( meet == gridSize ) {
+        if ( context.forward.open.empty() ) {
+            return roots[ 0 ];
+        }
+        return closestOpenCell( context.forward, gridInfo, end );
+    }
+
+    // point the backward half at the meeting cell, so the path reads from
+    // the end through forward parents alone
+    for ( size_t cell = meet; cell != roots[ 1 ]; ) {
+        size_t next = context.backward.parents[ cell ];
+        context.forward.parents[ next ] = cell;
+        cell = next;
+    }
+
+    return roots[ 1 ];
+}
+
+/// Walks the forward parents back from cell into outPath
+void buildPath( SearchContext & context, grid::Info gridInfo, size_t cell,
+                Path & outPath ) {
+    size_t gridSize = context.gridSize;
+    std::vector< size_t > & parent = context.forward.parents;
+
+    size_t pointsCapacity = outPath.points.capacity();
+    size_t debugCapacity = outPath.debugOpenPoints.capacity();
 
-    for ( size_t i : open ) {
-        path.debugOpenPoints.push_back( coord[ i ] );
+    outPath.points.clear();
+    outPath.debugOpenPoints.clear();
+
+    // report the open list in insertion order
+    if ( outPath.captureOpenPoints ) {
+        std::vector< size_t > & openCells = context.scratch;
+        openCells.assign( context.forward.open.begin(),
+                          context.forward.open.end() );
+        std::sort( openCells.begin(), openCells.end(),
+                   [ &context ]( size_t a, size_t b ) {
+                       return context.forward.orders[ a ] <
+                              context.forward.orders[ b ];
+                   } );
+        for ( size_t i : openCells ) {
+            outPath.debugOpenPoints.push_back(
+                grid::coord( gridInfo, i ) );
+        }
     }
 
     // return empty path
     // if ( parent[ endIndex ] == gridSize )
     //    return path;
 
-    // size_t cell = endIndex;
-    size_t cell = bestCell;
-
-    int watchdog2;
+    int watchdog2 = 0;
 
     const int segMaxLength = 10;
     int segCounter = 0;
 
-    while ( cell != gridSize ) {
-        // DEBUG_LOG() << "iterate reconstruct" << std::endl;
-
-        watchdog2++;
-        if ( watchdog2 >= 100000 ) {
-            return Path{};
-        }
-
-        grid::Coord c = coord[ cell ];
-        cell = parent[ cell ];
+    std::vector< grid::Coord > & points = outPath.points;
 
+    auto addPoint = [ & ]( grid::Coord c ) {
         // overwrite points that are colinear
-        if ( path.points.size() >= 2 && segCounter < segMaxLength ) {
-            grid::Coord & c1 = path.points[ path.points.size() - 2 ];
-            grid::Coord & c2 = path.points[ path.points.size() - 1 ];
+        if ( points.size() >= 2 && segCounter < segMaxLength ) {
+            grid::Coord & c1 = points[ points.size() - 2 ];
+            grid::Coord & c2 = points[ points.size() - 1 ];
 
             int dx1 = c2.x - c1.x;
             int dy1 = c2.y - c1.y;
@@ -240,17 +489,541 @@ Path shortestPath( grid::Info gridInfo, const std::vector< int > & gridData,
                 segCounter++;
             } else {
                 segCounter = 0;
-                path.points.push_back( c );
+                points.push_back( c );
             }
         } else {
             segCounter = 0;
-            path.points.push_back( c );
+            points.push_back( c );
+        }
+    };
+
+    while ( cell != gridSize ) {
+        // DEBUG_LOG() << "iterate reconstruct" << std::endl;
+
+        watchdog2++;
+        if ( watchdog2 >= 100000 ) {
+            points.clear();
+            outPath.debugOpenPoints.clear();
+            return;
+        }
+
+        grid::Coord c = grid::coord( gridInfo, cell );
+        cell = parent[ cell ];
+
+        addPoint( c );
+
+        if ( cell == gridSize ) {
+            break;
+        }
+
+        // jump points are joined by straight or diagonal runs of cells, walk
+        // them so the path looks the same as a plain A* path
+        grid::Coord next = grid::coord( gridInfo, cell );
+        int dx = sign( next.x - c.x );
+        int dy = sign( next.y - c.y );
+        c.x += dx;
+        c.y += dy;
+        while ( c.x != next.x || c.y != next.y ) {
+            addPoint( c );
+            c.x += dx;
+            c.y += dy;
         }
     }
 
-    std::reverse( path.points.begin(), path.points.end() );
+    std::reverse( points.begin(), points.end() );
+
+    if ( points.capacity() != pointsCapacity ||
+         outPath.debugOpenPoints.capacity() != debugCapacity ) {
+        context.allocationCount++;
+    }
+}
+
+} // namespace
+
+void startSearch( SearchContext & context, grid::Info gridInfo,
+                  grid::Coord start, grid::Coord end, SearchMode mode,
+                  Search & outSearch ) {
+    LOGGER_ASSERT( mode != kSearchBidirectional );
+
+    size_t startIndex = grid::index( gridInfo, start );
+    size_t gridSize = grid::size( gridInfo );
+
+    beginSearch( context, gridSize, false );
+
+    SearchSide & side = context.forward;
+    side.g[ startIndex ] = 0;
+    side.parents[ startIndex ] = gridSize;
+    OpenHeap{ side }.push( startIndex, heuristic( start, end ) );
+    setCellState( context, side, startIndex, kCellOpen );
 
+    outSearch.start = start;
+    outSearch.end = end;
+    outSearch.mode = mode;
+    outSearch.iterations = 0;
+    outSearch.finished = false;
+    outSearch.lastCell = startIndex;
+    context.expansions = 0;
+}
+
+bool continueSearch( SearchContext & context, Search & search,
+                     grid::Info gridInfo, const grid::Bitmap & gridData,
+                     int budget ) {
+    if ( search.finished ) {
+        return true;
+    }
+
+    grid::Coord end = search.end;
+    size_t startIndex = grid::index( gridInfo, search.start );
+    size_t endIndex = grid::index( gridInfo, end );
+
+    SearchSide & side = context.forward;
+    std::vector< int > & g = side.g;
+    std::vector< size_t > & parent = side.parents;
+    OpenHeap open{ side };
+
+    // offer a cell reached from bestCell with cost newG
+    auto relax = [ & ]( size_t bestCell, grid::Coord nborCoord, int newG ) {
+        size_t nbor = grid::index( gridInfo, nborCoord );
+
+        // ignore start cell (don't want to overwrite parent)
+        if ( nbor == startIndex ) {
+            return;
+        }
+
+        int newScore = newG + heuristic( nborCoord, end );
+
+        CellState nborState = cellState( context, side, nbor );
+
+        if ( nborState == kCellUnvisited ) {
+            g[ nbor ] = newG;
+            parent[ nbor ] = bestCell;
+            open.push( nbor, newScore );
+            setCellState( context, side, nbor, kCellOpen );
+        } else if ( newG < g[ nbor ] ) {
+            g[ nbor ] = newG;
+            parent[ nbor ] = bestCell;
+
+            if ( nborState == kCellOpen ) {
+                open.decrease( nbor, newScore );
+            } else {
+                ERROR_LOG() << "closed node re-evaluated!" << std::endl;
+                open.push( nbor, newScore );
+                setCellState( context, side, nbor, kCellOpen );
+            }
+        }
+    };
+
+    while ( !open.empty() ) {
+        // DEBUG_LOG() << "iterate astar" << std::endl;
+
+        if ( budget <= 0 ) {
+            return false;
+        }
+        budget--;
+
+        size_t bestCell = open.top();
+        search.iterations++;
+        context.expansions = search.iterations;
+        search.lastCell = bestCell;
+
+        open.pop();
+        setCellState( context, side, bestCell, kCellClosed );
+
+        // found the end
+        if ( bestCell == endIndex ) {
+            break;
+        }
+
+        grid::Coord bestCoord = grid::coord( gridInfo, bestCell );
+
+        if ( search.mode == kSearchJumpPoint ) {
+            grid::Coord dirs[ 8 ];
+            int dirCount;
+
+            if ( bestCell == startIndex ) {
+                std::copy( kNborOffsets.begin(), kNborOffsets.end(), dirs );
+                dirCount = 8;
+            } else {
+                grid::Coord from =
+                    grid::coord( gridInfo, parent[ bestCell ] );
+                int dx = sign( bestCoord.x - from.x );
+                int dy = sign( bestCoord.y - from.y );
+                dirCount = prunedDirections( gridInfo, gridData, bestCoord, dx,
+                                             dy, dirs );
+            }
+
+            for ( int i = 0; i < dirCount; i++ ) {
+                grid::Coord jumpCoord;
+                if ( jump( gridInfo, gridData, bestCoord, dirs[ i ].x,
+                           dirs[ i ].y, end, jumpCoord ) ) {
+                    int distance = octileHeuristic( bestCoord, jumpCoord );
+                    relax( bestCell, jumpCoord, g[ bestCell ] + distance );
+                }
+            }
+
+            continue;
+        }
+
+        // look at neighbors
+        for ( size_t i = 0; i < 8; i++ ) {
+            grid::Coord offset = kNborOffsets[ i ];
+            int weight = kNborWeights[ i ];
+
+            grid::Coord nborCoord;
+            nborCoord.x = bestCoord.x + offset.x;
+            nborCoord.y = bestCoord.y + offset.y;
+
+            // weight += randCost( nborCoord );
+
+            // out of bounds
+            if ( !grid::contains( gridInfo, nborCoord ) ) {
+                continue;
+            }
+
+            // skip non solids
+            if ( grid::test( gridData, nborCoord ) ) {
+                continue;
+            }
+
+            relax( bestCell, nborCoord, g[ bestCell ] + weight );
+        }
+    }
+
+    search.finished = true;
+    return true;
+}
+
+void finishSearch( SearchContext & context, const Search & search,
+                   grid::Info gridInfo, Path & outPath ) {
+    size_t cell = search.lastCell;
+    if ( !search.finished ) {
+        cell = closestOpenCell( context.forward, gridInfo, search.end );
+    }
+
+    buildPath( context, gridInfo, cell, outPath );
+}
+
+void shortestPath( SearchContext & context, grid::Info gridInfo,
+                   const grid::Bitmap & gridData, grid::Coord start,
+                   grid::Coord end, int iterationMax, Path & outPath,
+                   SearchMode mode ) {
+    if ( mode == kSearchBidirectional ) {
+        beginSearch( context, grid::size( gridInfo ), true );
+        size_t cell = searchBidirectional( context, gridInfo, gridData, start,
+                                           end, iterationMax );
+        buildPath( context, gridInfo, cell, outPath );
+        return;
+    }
+
+    // the iteration that reaches iterationMax gives up before expanding
+    Search search;
+    startSearch( context, gridInfo, start, end, mode, search );
+    continueSearch( context, search, gridInfo, gridData, iterationMax - 1 );
+    finishSearch( context, search, gridInfo, outPath );
+}
+
+Path shortestPath( grid::Info gridInfo, const grid::Bitmap & gridData,
+                   grid::Coord start, grid::Coord end, int iterationMax ) {
+    SearchContext context;
+    Path path;
+    path.captureOpenPoints = true;
+    shortestPath( context, gridInfo, gridData, start, end, iterationMax,
+                  path );
     return path;
 }
 
+bool lineOfSight( SearchContext & context, const grid::Bitmap & gridData,
+                  grid::Coord a, grid::Coord b ) {
+    std::vector< grid::Coord > & cells = context.lineCells;
+    cells.clear();
+    grid::appendLine( a, b, cells );
+
+    for ( grid::Coord c : cells ) {
+        if ( grid::test( gridData, c ) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void smoothPath( SearchContext & context, const grid::Bitmap & gridData,
+                 std::vector< grid::Coord > & points ) {
+    if ( points.size() < 3 ) {
+        return;
+    }
+
+    // points[ kept - 1 ] is the last waypoint kept, a point can go if that
+    // one sees the point after it
+    size_t kept = 1;
+    for ( size_t i = 1; i + 1 < points.size(); i++ ) {
+        if ( !lineOfSight( context, gridData, points[ kept - 1 ],
+                           points[ i + 1 ] ) ) {
+            points[ kept++ ] = points[ i ];
+        }
+    }
+
+    points[ kept++ ] = points.back();
+    points.resize( kept );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void testShortestPath() {
+    grid::Info info{ 8, 8 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    Path path = shortestPath( info, data, { 0, 0 }, { 7, 7 }, 1000 );
+
+    LOGGER_ASSERT( path.points.size() == 2 );
+    LOGGER_ASSERT( path.points.back().x == 7 && path.points.back().y == 7 );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int pathCost( const Path & path ) {
+    int cost = 0;
+    for ( size_t i = 1; i < path.points.size(); i++ ) {
+        cost += octileHeuristic( path.points[ i - 1 ], path.points[ i ] );
+    }
+    return cost;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void testJumpPointSearch() {
+    grid::Info info{ 64, 48 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    for ( int y = 0; y < 40; y++ ) {
+        grid::set( data, 20, y, true );
+        grid::set( data, 40, info.height - 1 - y, true );
+    }
+
+    grid::Coord start{ 2, 2 };
+    grid::Coord end{ 60, 2 };
+
+    SearchContext context;
+    Path astarPath;
+    Path jpsPath;
+
+    shortestPath( context, info, data, start, end, 100000, astarPath );
+    int astarExpansions = context.expansions;
+    shortestPath( context, info, data, start, end, 100000, jpsPath,
+                  kSearchJumpPoint );
+    int jpsExpansions = context.expansions;
+
+    LOGGER_ASSERT( jpsPath.points.back().x == end.x &&
+                   jpsPath.points.back().y == end.y );
+    LOGGER_ASSERT( pathCost( astarPath ) == pathCost( jpsPath ) );
+    LOGGER_ASSERT( jpsExpansions < astarExpansions );
+}
+
+static void testBidirectional() {
+    grid::Info info{ 96, 64 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    // the end sits in a room whose door faces away from the start
+    for ( int i = 0; i < 30; i++ ) {
+        grid::set( data, 50 + i, 10, true );
+        grid::set( data, 50 + i, 40, true );
+        grid::set( data, 50, 10 + i, true );
+        if ( i < 12 || i > 18 ) {
+            grid::set( data, 80, 10 + i, true );
+        }
+    }
+
+    grid::Coord start{ 4, 25 };
+    grid::Coord end{ 60, 25 };
+
+    SearchContext context;
+    Path astarPath;
+    Path bidirectionalPath;
+
+    shortestPath( context, info, data, start, end, 100000, astarPath );
+    int astarExpansions = context.expansions;
+    shortestPath( context, info, data, start, end, 100000, bidirectionalPath,
+                  kSearchBidirectional );
+    int bidirectionalExpansions = context.expansions;
+
+    LOGGER_ASSERT( bidirectionalPath.points.front().x == start.x &&
+                   bidirectionalPath.points.front().y == start.y );
+    LOGGER_ASSERT( bidirectionalPath.points.back().x == end.x &&
+                   bidirectionalPath.points.back().y == end.y );
+    LOGGER_ASSERT( pathCost( astarPath ) == pathCost( bidirectionalPath ) );
+    LOGGER_ASSERT( bidirectionalExpansions < astarExpansions );
+}
+
+static void testSlicedSearch() {
+    grid::Info info{ 64, 48 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    for ( int y = 0; y < 40; y++ ) {
+        grid::set( data, 20, y, true );
+        grid::set( data, 40, info.height - 1 - y, true );
+    }
+
+    grid::Coord start{ 2, 2 };
+    grid::Coord end{ 60, 2 };
+
+    SearchContext context;
+    Path wholePath;
+    Path slicedPath;
+
+    shortestPath( context, info, data, start, end, 100000, wholePath );
+
+    Search search;
+    startSearch( context, info, start, end, kSearchAstar, search );
+    int slices = 1;
+    while ( !continueSearch( context, search, info, data, 16 ) ) {
+        slices++;
+    }
+    finishSearch( context, search, info, slicedPath );
+
+    LOGGER_ASSERT( slices > 1 );
+    LOGGER_ASSERT( slicedPath.points.size() == wholePath.points.size() );
+    LOGGER_ASSERT( pathCost( slicedPath ) == pathCost( wholePath ) );
+}
+
+static void testGraphSearch() {
+    grid::Info info{ 64, 48 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    for ( int y = 0; y < 40; y++ ) {
+        grid::set( data, 20, y, true );
+        grid::set( data, 40, info.height - 1 - y, true );
+    }
+
+    grid::Coord start{ 2, 2 };
+    grid::Coord end{ 60, 2 };
+
+    // the grid as a generic graph, ids are row major cell indices
+    auto coordOf = [ & ]( long id ) {
+        return grid::Coord{ int( id % info.width ), int( id / info.width ) };
+    };
+    auto neighbors = [ & ]( long id, auto && visit ) {
+        grid::Coord c = coordOf( id );
+        for ( size_t i = 0; i < 8; i++ ) {
+            grid::Coord n{ c.x + kNborOffsets[ i ].x,
+                           c.y + kNborOffsets[ i ].y };
+            if ( grid::contains( info, n ) && !grid::test( data, n ) ) {
+                visit( long( grid::index( info, n ) ), kNborWeights[ i ] );
+            }
+        }
+    };
+    auto heuristic = [ & ]( long id ) {
+        return octileHeuristic( coordOf( id ), end );
+    };
+
+    Graph< long > graph;
+    long startId = grid::index( info, start );
+    long endId = grid::index( info, end );
+    bool found = search( graph, startId, endId, neighbors, heuristic );
+
+    std::vector< long > ids;
+    buildPath( graph, endId, ids );
+
+    Path graphPath;
+    for ( long id : ids ) {
+        graphPath.points.push_back( coordOf( id ) );
+    }
+
+    SearchContext context;
+    Path gridPath;
+    shortestPath( context, info, data, start, end, 100000, gridPath );
+
+    LOGGER_ASSERT( found && ids.front() == startId && ids.back() == endId );
+    LOGGER_ASSERT( pathCost( graphPath ) == pathCost( gridPath ) );
+
+    // a wall all the way across cuts the end off
+    for ( int y = 0; y < info.height; y++ ) {
+        grid::set( data, 50, y, true );
+    }
+    LOGGER_ASSERT( !search( graph, startId, endId, neighbors, heuristic ) );
+}
+
+static void testSmoothPath() {
+    grid::Info info{ 64, 48 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    for ( int y = 0; y < 40; y++ ) {
+        grid::set( data, 20, y, true );
+    }
+
+    grid::Coord start{ 2, 30 };
+    grid::Coord end{ 60, 5 };
+
+    SearchContext context;
+    Path path;
+    shortestPath( context, info, data, start, end, 100000, path );
+    size_t rawCount = path.points.size();
+
+    smoothPath( context, data, path.points );
+
+    // one corner around the bottom of the wall is left
+    LOGGER_ASSERT( path.points.size() == 3 && path.points.size() < rawCount );
+    LOGGER_ASSERT( path.points.back().x == end.x &&
+                   path.points.back().y == end.y );
+    for ( size_t i = 0; i + 1 < path.points.size(); i++ ) {
+        LOGGER_ASSERT( lineOfSight( context, data, path.points[ i ],
+                                    path.points[ i + 1 ] ) );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static void benchmarkShortestPath() {
+    grid::Info info{ 400, 300 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    // a long wall with a gap at the bottom forces a wide search
+    for ( int y = 0; y < info.height - 10; y++ ) {
+        grid::set( data, info.width / 2, y, true );
+    }
+
+    grid::Coord start{ info.width / 2 - 10, 10 };
+    grid::Coord end{ info.width / 2 + 10, 10 };
+
+    const int runs = 10;
+
+    SearchContext context;
+    Path path;
+
+    // warm up the context so the timed runs don't allocate
+    shortestPath( context, info, data, start, end, 1000000, path );
+    size_t allocations = context.allocationCount;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for ( int i = 0; i < runs; i++ ) {
+        shortestPath( context, info, data, start, end, 1000000, path );
+        LOGGER_ASSERT( !path.points.empty() );
+    }
+    auto t1 = std::chrono::steady_clock::now();
+
+    LOGGER_ASSERT( context.allocationCount == allocations );
+
+    float ms = std::chrono::duration< float, std::milli >( t1 - t0 ).count();
+    DEBUG_LOG() << "shortestPath 400x300: " << ms / runs << " ms/query"
+                << std::endl;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+void runTests() {
+    testShortestPath();
+    testJumpPointSearch();
+    testBidirectional();
+    testSlicedSearch();
+    testGraphSearch();
+    testSmoothPath();
+    benchmarkShortestPath();
+}
+
 } // namespace astar
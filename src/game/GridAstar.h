@@ -8,10 +8,113 @@ namespace astar {
 
 struct Path {
     std::vector< grid::Coord > points;
+
+    // the open set left when the search ended, only filled in for the debug
+    // overlay when captureOpenPoints is set
+    bool captureOpenPoints = false;
     std::vector< grid::Coord > debugOpenPoints;
 };
 
-Path shortestPath( grid::Info gridInfo, const std::vector< int > & gridData,
+/// Octile distance with the same 10/14 weights the searches use
+int octileHeuristic( grid::Coord node, grid::Coord end );
+
+enum SearchMode {
+    kSearchAstar = 0,
+    // jump point search, only valid for uniform cost grids
+    kSearchJumpPoint,
+    // A* from both ends at once, meeting in the middle
+    kSearchBidirectional,
+};
+
+/// Scratch of one search frontier. Cells are stamped with the generation of
+/// the query that last touched them, so nothing has to be cleared between
+/// queries.
+struct SearchSide {
+    std::vector< unsigned > stamps;
+    std::vector< unsigned char > cellStates;
+    std::vector< int > g;
+    std::vector< size_t > parents;
+
+    // open set, an indexed binary min-heap
+    std::vector< size_t > open;
+    std::vector< int > scores;
+    std::vector< unsigned > orders;
+    std::vector< size_t > heapPositions;
+    unsigned nextOrder = 0;
+};
+
+/// Persistent scratch memory for grid searches
+struct SearchContext {
+    size_t gridSize = 0;
+    unsigned generation = 0;
+
+    SearchSide forward;
+
+    // searches back from the end, only sized once a bidirectional search ran
+    SearchSide backward;
+
+    std::vector< size_t > scratch;
+    std::vector< grid::Coord > lineCells;
+
+    // cells expanded by the last query
+    int expansions = 0;
+
+    // times any buffer had to grow, stays flat once the context is warm
+    size_t allocationCount = 0;
+};
+
+/// Reuses the memory of both the context and outPath
+void shortestPath( SearchContext & context, grid::Info gridInfo,
+                   const grid::Bitmap & gridData, grid::Coord start,
+                   grid::Coord end, int iterationMax, Path & outPath,
+                   SearchMode mode = kSearchAstar );
+
+Path shortestPath( grid::Info gridInfo, const grid::Bitmap & gridData,
                    grid::Coord start, grid::Coord end, int iterationMax );
 
+/// A search run a slice at a time. Its open set and costs live in the context
+/// it was started in, which can't run another search until this one is done.
+struct Search {
+    grid::Coord start;
+    grid::Coord end;
+    SearchMode mode;
+
+    // cells expanded so far
+    int iterations = 0;
+
+    // reached the end or ran out of cells
+    bool finished = false;
+
+    // last cell taken off the open set
+    size_t lastCell = 0;
+};
+
+/// A* and jump point search only
+void startSearch( SearchContext & context, grid::Info gridInfo,
+                  grid::Coord start, grid::Coord end, SearchMode mode,
+                  Search & outSearch );
+
+/// Expands up to budget more cells, the grid must not change in between.
+/// Returns whether the search is finished.
+bool continueSearch( SearchContext & context, Search & search,
+                     grid::Info gridInfo, const grid::Bitmap & gridData,
+                     int budget );
+
+/// Builds the path found so far. An unfinished search ends at the open cell
+/// closest to the end.
+void finishSearch( SearchContext & context, const Search & search,
+                   grid::Info gridInfo, Path & outPath );
+
+/// Whether the straight line between the centers of a and b only crosses
+/// walkable cells
+bool lineOfSight( SearchContext & context, const grid::Bitmap & gridData,
+                  grid::Coord a, grid::Coord b );
+
+/// String pulls a path in place, dropping every waypoint the last kept one
+/// can see past. Segments come out at any angle.
+void smoothPath( SearchContext & context, const grid::Bitmap & gridData,
+                 std::vector< grid::Coord > & points );
+
+void runTests();
+
 } // namespace astar
@@ -0,0 +1,434 @@
+#include "GridDstar.h"
+
+#include "GridAstar.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <limits>
+#include <random>
+
+namespace dstar {
+
+static const grid::Coord kNborOffsets[ 8 ] = {
+    grid::Coord{ 1, 0 },  grid::Coord{ -1, 0 },  grid::Coord{ 0, 1 },
+    grid::Coord{ 0, -1 }, grid::Coord{ 1, 1 },   grid::Coord{ -1, 1 },
+    grid::Coord{ 1, -1 }, grid::Coord{ -1, -1 },
+};
+static const int kNborWeights[ 8 ] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+
+// leaves headroom so infinity plus an edge cost doesn't overflow
+static const int kInfinity = std::numeric_limits< int >::max() / 2;
+
+static const size_t kNotQueued = std::numeric_limits< size_t >::max();
+
+namespace {
+
+bool less( Key a, Key b ) {
+    return a.k1 < b.k1 || ( a.k1 == b.k1 && a.k2 < b.k2 );
+}
+
+bool blocked( const grid::Bitmap & gridData, grid::Coord c ) {
+    return grid::test( gridData, c );
+}
+
+/// Edge cost between neighbors, infinite if either end is blocked
+int cost( const grid::Bitmap & gridData, grid::Coord a, grid::Coord b,
+          int weight ) {
+    if ( blocked( gridData, a ) || blocked( gridData, b ) ) {
+        return kInfinity;
+    }
+    return weight;
+}
+
+Key calculateKey( const Planner & planner, size_t cell ) {
+    grid::Coord c = grid::coord( planner.gridInfo, cell );
+    int m = std::min( planner.g[ cell ], planner.rhs[ cell ] );
+    if ( m >= kInfinity ) {
+        return Key{ kInfinity, kInfinity };
+    }
+    return Key{ m + astar::octileHeuristic( planner.start, c ) + planner.km,
+                m };
+}
+
+void place( Planner & planner, size_t i, size_t cell ) {
+    planner.queue[ i ] = cell;
+    planner.queuePositions[ cell ] = i;
+}
+
+void siftUp( Planner & planner, size_t i ) {
+    size_t cell = planner.queue[ i ];
+    while ( i > 0 ) {
+        size_t up = ( i - 1 ) / 2;
+        if ( !less( planner.keys[ cell ],
+                    planner.keys[ planner.queue[ up ] ] ) ) {
+            break;
+        }
+        place( planner, i, planner.queue[ up ] );
+        i = up;
+    }
+    place( planner, i, cell );
+}
+
+void siftDown( Planner & planner, size_t i ) {
+    std::vector< size_t > & queue = planner.queue;
+    size_t cell = queue[ i ];
+    size_t n = queue.size();
+    while ( true ) {
+        size_t child = 2 * i + 1;
+        if ( child >= n ) {
+            break;
+        }
+        if ( child + 1 < n && less( planner.keys[ queue[ child + 1 ] ],
+                                    planner.keys[ queue[ child ] ] ) ) {
+            child++;
+        }
+        if ( !less( planner.keys[ queue[ child ] ], planner.keys[ cell ] ) ) {
+            break;
+        }
+        place( planner, i, queue[ child ] );
+        i = child;
+    }
+    place( planner, i, cell );
+}
+
+void queueRemove( Planner & planner, size_t cell ) {
+    size_t i = planner.queuePositions[ cell ];
+    size_t last = planner.queue.back();
+    planner.queue.pop_back();
+    planner.queuePositions[ cell ] = kNotQueued;
+
+    if ( last != cell ) {
+        place( planner, i, last );
+        siftDown( planner, i );
+        siftUp( planner, planner.queuePositions[ last ] );
+    }
+}
+
+void queueSet( Planner & planner, size_t cell, Key key ) {
+    planner.keys[ cell ] = key;
+
+    if ( planner.queuePositions[ cell ] == kNotQueued ) {
+        planner.queue.push_back( cell );
+        siftUp( planner, planner.queue.size() - 1 );
+    } else {
+        size_t i = planner.queuePositions[ cell ];
+        siftDown( planner, i );
+        siftUp( planner, planner.queuePositions[ cell ] );
+    }
+}
+
+void updateVertex( Planner & planner, size_t cell ) {
+    bool queued = planner.queuePositions[ cell ] != kNotQueued;
+
+    if ( planner.g[ cell ] != planner.rhs[ cell ] ) {
+        queueSet( planner, cell, calculateKey( planner, cell ) );
+    } else if ( queued ) {
+        queueRemove( planner, cell );
+    }
+}
+
+/// One step lookahead, the best successor cost of a cell
+int bestRhs( const Planner & planner, const grid::Bitmap & gridData,
+             grid::Coord c ) {
+    int best = kInfinity;
+
+    for ( int i = 0; i < 8; i++ ) {
+        grid::Coord n{ c.x + kNborOffsets[ i ].x, c.y + kNborOffsets[ i ].y };
+        if ( !grid::contains( planner.gridInfo, n ) ) {
+            continue;
+        }
+
+        int edge = cost( gridData, c, n, kNborWeights[ i ] );
+        int g = planner.g[ grid::index( planner.gridInfo, n ) ];
+        if ( edge < kInfinity && g < kInfinity ) {
+            best = std::min( best, edge + g );
+        }
+    }
+
+    return best;
+}
+
+void recompute( Planner & planner, const grid::Bitmap & gridData,
+                grid::Coord c ) {
+    size_t cell = grid::index( planner.gridInfo, c );
+    if ( c.x != planner.goal.x || c.y != planner.goal.y ) {
+        planner.rhs[ cell ] = bestRhs( planner, gridData, c );
+    }
+    updateVertex( planner, cell );
+}
+
+} // namespace
+
+void init( Planner & planner, grid::Info gridInfo, grid::Coord start,
+           grid::Coord goal ) {
+    size_t gridSize = grid::size( gridInfo );
+
+    planner.initialized = true;
+    planner.gridInfo = gridInfo;
+    planner.start = start;
+    planner.lastStart = start;
+    planner.goal = goal;
+    planner.km = 0;
+
+    planner.g.assign( gridSize, kInfinity );
+    planner.rhs.assign( gridSize, kInfinity );
+    planner.keys.assign( gridSize, Key{ kInfinity, kInfinity } );
+    planner.queuePositions.assign( gridSize, kNotQueued );
+    planner.queue.clear();
+    planner.expansions = 0;
+
+    size_t goalCell = grid::index( gridInfo, goal );
+    planner.rhs[ goalCell ] = 0;
+    queueSet( planner, goalCell, calculateKey( planner, goalCell ) );
+}
+
+void moveStart( Planner & planner, grid::Coord start ) {
+    planner.start = start;
+    planner.km += astar::octileHeuristic( planner.lastStart, start );
+    planner.lastStart = start;
+}
+
+void updateCell( Planner & planner, const grid::Bitmap & gridData,
+                 grid::Coord cell ) {
+    // every edge touching the cell changed, so the cell and its neighbors
+    // need a fresh lookahead
+    recompute( planner, gridData, cell );
+
+    for ( int i = 0; i < 8; i++ ) {
+        grid::Coord n{ cell.x + kNborOffsets[ i ].x,
+                       cell.y + kNborOffsets[ i ].y };
+        if ( grid::contains( planner.gridInfo, n ) ) {
+            recompute( planner, gridData, n );
+        }
+    }
+}
+
+bool computeShortestPath( Planner & planner, const grid::Bitmap & gridData ) {
+    size_t startCell = grid::index( planner.gridInfo, planner.start );
+    size_t goalCell = grid::index( planner.gridInfo, planner.goal );
+
+    planner.expansions = 0;
+
+    while ( !planner.queue.empty() ) {
+        size_t cell = planner.queue[ 0 ];
+        Key oldKey = planner.keys[ cell ];
+
+        bool startConsistent =
+            planner.rhs[ startCell ] <= planner.g[ startCell ];
+        if ( !less( oldKey, calculateKey( planner, startCell ) ) &&
+             startConsistent ) {
+            break;
+        }
+
+        planner.expansions++;
+
+        Key newKey = calculateKey( planner, cell );
+        grid::Coord c = grid::coord( planner.gridInfo, cell );
+
+        if ( less( oldKey, newKey ) ) {
+            queueSet( planner, cell, newKey );
+        } else if ( planner.g[ cell ] > planner.rhs[ cell ] ) {
+            planner.g[ cell ] = planner.rhs[ cell ];
+            queueRemove( planner, cell );
+
+            for ( int i = 0; i < 8; i++ ) {
+                grid::Coord n{ c.x + kNborOffsets[ i ].x,
+                               c.y + kNborOffsets[ i ].y };
+                if ( !grid::contains( planner.gridInfo, n ) ) {
+                    continue;
+                }
+
+                size_t nborCell = grid::index( planner.gridInfo, n );
+                int edge = cost( gridData, n, c, kNborWeights[ i ] );
+
+                if ( nborCell != goalCell && edge < kInfinity ) {
+                    planner.rhs[ nborCell ] =
+                        std::min( planner.rhs[ nborCell ],
+                                  edge + planner.g[ cell ] );
+                }
+                updateVertex( planner, nborCell );
+            }
+        } else {
+            planner.g[ cell ] = kInfinity;
+
+            recompute( planner, gridData, c );
+            for ( int i = 0; i < 8; i++ ) {
+                grid::Coord n{ c.x + kNborOffsets[ i ].x,
+                               c.y + kNborOffsets[ i ].y };
+                if ( grid::contains( planner.gridInfo, n ) ) {
+                    recompute( planner, gridData, n );
+                }
+            }
+        }
+    }
+
+    return planner.rhs[ startCell ] < kInfinity;
+}
+
+bool extractPath( const Planner & planner, const grid::Bitmap & gridData,
+                  std::vector< grid::Coord > & outPoints ) {
+    outPoints.clear();
+
+    grid::Coord c = planner.start;
+    if ( planner.rhs[ grid::index( planner.gridInfo, c ) ] >= kInfinity ) {
+        return false;
+    }
+
+    size_t watchdog = grid::size( planner.gridInfo );
+
+    outPoints.push_back( c );
+
+    while ( c.x != planner.goal.x || c.y != planner.goal.y ) {
+        if ( watchdog-- == 0 ) {
+            outPoints.clear();
+            return false;
+        }
+
+        grid::Coord best = c;
+        int bestCost = kInfinity;
+
+        for ( int i = 0; i < 8; i++ ) {
+            grid::Coord n{ c.x + kNborOffsets[ i ].x,
+                           c.y + kNborOffsets[ i ].y };
+            if ( !grid::contains( planner.gridInfo, n ) ) {
+                continue;
+            }
+
+            int edge = cost( gridData, c, n, kNborWeights[ i ] );
+            int g = planner.g[ grid::index( planner.gridInfo, n ) ];
+            if ( edge < kInfinity && g < kInfinity && edge + g < bestCost ) {
+                best = n;
+                bestCost = edge + g;
+            }
+        }
+
+        if ( bestCost == kInfinity ) {
+            outPoints.clear();
+            return false;
+        }
+
+        // overwrite points that are colinear
+        if ( outPoints.size() >= 2 ) {
+            grid::Coord c1 = outPoints[ outPoints.size() - 2 ];
+            grid::Coord c2 = outPoints.back();
+            int dx1 = c2.x - c1.x;
+            int dy1 = c2.y - c1.y;
+            int dx2 = best.x - c2.x;
+            int dy2 = best.y - c2.y;
+
+            if ( dx1 * dy2 == dx2 * dy1 ) {
+                outPoints.back() = best;
+            } else {
+                outPoints.push_back( best );
+            }
+        } else {
+            outPoints.push_back( best );
+        }
+
+        c = best;
+    }
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+static int pathCost( const std::vector< grid::Coord > & points ) {
+    int cost = 0;
+    for ( size_t i = 1; i < points.size(); i++ ) {
+        cost += astar::octileHeuristic( points[ i - 1 ], points[ i ] );
+    }
+    return cost;
+}
+
+/// Random walls put up and torn down, with the start moving now and then,
+/// repaired with updateCell have to cost the same as a fresh A* search
+static void testWallEdits() {
+    grid::Info info{ 48, 40 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    std::mt19937 rng( 3 );
+    for ( int y = 0; y < info.height; y++ ) {
+        for ( int x = 0; x < info.width; x++ ) {
+            grid::set( data, x, y, rng() % 5 == 0 );
+        }
+    }
+
+    grid::Coord start{ 2, 2 };
+    grid::Coord goal{ 45, 37 };
+    grid::set( data, start.x, start.y, false );
+    grid::set( data, goal.x, goal.y, false );
+
+    Planner planner;
+    init( planner, info, start, goal );
+
+    astar::SearchContext context;
+    astar::Path astarPath;
+    std::vector< grid::Coord > points;
+
+    for ( int edit = 0; edit < 300; edit++ ) {
+        grid::Coord cell{ int( rng() % info.width ),
+                          int( rng() % info.height ) };
+        bool endpoint = ( cell.x == start.x && cell.y == start.y ) ||
+                        ( cell.x == goal.x && cell.y == goal.y );
+        if ( !endpoint ) {
+            grid::set( data, cell.x, cell.y, !grid::test( data, cell ) );
+            updateCell( planner, data, cell );
+        }
+
+        // walk a step along the current path
+        if ( edit % 10 == 0 && extractPath( planner, data, points ) &&
+             points.size() > 1 ) {
+            grid::Coord next = points[ 1 ];
+            start.x += ( next.x > start.x ) - ( next.x < start.x );
+            start.y += ( next.y > start.y ) - ( next.y < start.y );
+            if ( start.x == goal.x && start.y == goal.y ) {
+                break;
+            }
+            moveStart( planner, start );
+        }
+
+        bool found = computeShortestPath( planner, data );
+        astar::shortestPath( context, info, data, start, goal, 1000000,
+                             astarPath );
+
+        grid::Coord last = astarPath.points.back();
+        bool astarFound = last.x == goal.x && last.y == goal.y;
+        LOGGER_ASSERT( found == astarFound );
+        if ( found && astarFound ) {
+            size_t startCell = grid::index( info, start );
+            LOGGER_ASSERT( planner.rhs[ startCell ] ==
+                           pathCost( astarPath.points ) );
+            LOGGER_ASSERT( extractPath( planner, data, points ) );
+            LOGGER_ASSERT( pathCost( points ) == planner.rhs[ startCell ] );
+        }
+    }
+
+    // walled in goal, then opened up again
+    for ( bool wall : { true, false } ) {
+        for ( int i = 0; i < 8; i++ ) {
+            grid::Coord n{ goal.x + kNborOffsets[ i ].x,
+                           goal.y + kNborOffsets[ i ].y };
+            if ( grid::contains( info, n ) ) {
+                grid::set( data, n.x, n.y, wall );
+                updateCell( planner, data, n );
+            }
+        }
+
+        bool found = computeShortestPath( planner, data );
+        astar::shortestPath( context, info, data, start, goal, 1000000,
+                             astarPath );
+        LOGGER_ASSERT( found == !wall );
+        if ( found ) {
+            LOGGER_ASSERT( planner.rhs[ grid::index( info, start ) ] ==
+                           pathCost( astarPath.points ) );
+        }
+    }
+}
+
+void runTests() {
+    testWallEdits();
+}
+
+} // namespace dstar
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <vector>
+
+namespace dstar {
+
+struct Key {
+    int k1;
+    int k2;
+};
+
+/// D* Lite search state for one goal. The search runs backward from the goal,
+/// so wall edits and a moving start only repair the part of the search they
+/// invalidate instead of starting over.
+struct Planner {
+    bool initialized = false;
+
+    grid::Info gridInfo;
+    grid::Coord start;
+    grid::Coord goal;
+    grid::Coord lastStart;
+    int km;
+
+    std::vector< int > g;
+    std::vector< int > rhs;
+
+    // queue of inconsistent cells, an indexed binary min-heap
+    std::vector< size_t > queue;
+    std::vector< Key > keys;
+    std::vector< size_t > queuePositions;
+
+    // cells expanded by the last computeShortestPath
+    int expansions;
+};
+
+void init( Planner & planner, grid::Info gridInfo, grid::Coord start,
+           grid::Coord goal );
+
+void moveStart( Planner & planner, grid::Coord start );
+
+/// Call after cell changed between walkable and blocked in gridData
+void updateCell( Planner & planner, const grid::Bitmap & gridData,
+                 grid::Coord cell );
+
+/// Returns false if the goal can't be reached from the start
+bool computeShortestPath( Planner & planner, const grid::Bitmap & gridData );
+
+/// Walks the solved search from start to goal, merging colinear cells
+bool extractPath( const Planner & planner, const grid::Bitmap & gridData,
+                  std::vector< grid::Coord > & outPoints );
+
+void runTests();
+
+} // namespace dstar
@@ -0,0 +1,624 @@
+#include "Hpa.h"
+
+#include "GridAstar.h"
+#include "Logging.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <random>
+
+namespace hpa {
+
+static const grid::Coord kNborOffsets[ 8 ] = {
+    grid::Coord{ 1, 0 },  grid::Coord{ -1, 0 },  grid::Coord{ 0, 1 },
+    grid::Coord{ 0, -1 }, grid::Coord{ 1, 1 },   grid::Coord{ -1, 1 },
+    grid::Coord{ 1, -1 }, grid::Coord{ -1, -1 },
+};
+static const int kNborWeights[ 8 ] = { 10, 10, 10, 10, 14, 14, 14, 14 };
+
+// open border segments shorter than this get a single entrance
+static const int kSplitLength = 6;
+
+static const int kInfinity = std::numeric_limits< int >::max();
+
+namespace {
+
+using OpenEntry = std::pair< int, int >;
+
+struct Bounds {
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+};
+
+Bounds clusterBounds( const Graph & graph, int cluster ) {
+    grid::Coord c = grid::coord( graph.clusterInfo, cluster );
+
+    Bounds b;
+    b.x0 = c.x * graph.clusterSize;
+    b.y0 = c.y * graph.clusterSize;
+    b.x1 = std::min( b.x0 + graph.clusterSize, graph.gridInfo.width ) - 1;
+    b.y1 = std::min( b.y0 + graph.clusterSize, graph.gridInfo.height ) - 1;
+    return b;
+}
+
+int clusterOf( const Graph & graph, grid::Coord c ) {
+    return grid::index( graph.clusterInfo, c.x / graph.clusterSize,
+                        c.y / graph.clusterSize );
+}
+
+bool walkable( const Graph & graph, const grid::Bitmap & gridData, int x,
+               int y ) {
+    return grid::contains( graph.gridInfo, x, y ) &&
+           !grid::test( gridData, x, y );
+}
+
+void pushOpen( std::vector< OpenEntry > & open, int cost, int node ) {
+    open.push_back( OpenEntry{ cost, node } );
+    std::push_heap( open.begin(), open.end(), std::greater< OpenEntry >() );
+}
+
+OpenEntry popOpen( std::vector< OpenEntry > & open ) {
+    std::pop_heap( open.begin(), open.end(), std::greater< OpenEntry >() );
+    OpenEntry e = open.back();
+    open.pop_back();
+    return e;
+}
+
+/// Dijkstra from source that never leaves the cluster. Costs end up in
+/// graph.cellCosts, indexed by cell relative to the cluster's corner.
+void searchCluster( Graph & graph, const grid::Bitmap & gridData,
+                    int cluster, grid::Coord source ) {
+    Bounds b = clusterBounds( graph, cluster );
+    int size = graph.clusterSize;
+
+    auto local = [ & ]( int x, int y ) {
+        return ( x - b.x0 ) + ( y - b.y0 ) * size;
+    };
+
+    graph.cellCosts.assign( size * size, kInfinity );
+    graph.open.clear();
+
+    graph.cellCosts[ local( source.x, source.y ) ] = 0;
+    pushOpen( graph.open, 0, local( source.x, source.y ) );
+
+    while ( !graph.open.empty() ) {
+        auto [ cost, cell ] = popOpen( graph.open );
+
+        if ( cost > graph.cellCosts[ cell ] ) {
+            continue;
+        }
+
+        int x = b.x0 + cell % size;
+        int y = b.y0 + cell / size;
+
+        for ( int i = 0; i < 8; i++ ) {
+            int nx = x + kNborOffsets[ i ].x;
+            int ny = y + kNborOffsets[ i ].y;
+
+            if ( nx < b.x0 || ny < b.y0 || nx > b.x1 || ny > b.y1 ) {
+                continue;
+            }
+
+            if ( !walkable( graph, gridData, nx, ny ) ) {
+                continue;
+            }
+
+            int newCost = cost + kNborWeights[ i ];
+            int nborCell = local( nx, ny );
+
+            if ( newCost < graph.cellCosts[ nborCell ] ) {
+                graph.cellCosts[ nborCell ] = newCost;
+                pushOpen( graph.open, newCost, nborCell );
+            }
+        }
+    }
+}
+
+int cellCost( const Graph & graph, int cluster, grid::Coord c ) {
+    Bounds b = clusterBounds( graph, cluster );
+    int cell = ( c.x - b.x0 ) + ( c.y - b.y0 ) * graph.clusterSize;
+    return graph.cellCosts[ cell ];
+}
+
+void addEntrance( std::vector< grid::Coord > & entrances, grid::Coord c ) {
+    for ( grid::Coord e : entrances ) {
+        if ( e.x == c.x && e.y == c.y ) {
+            return;
+        }
+    }
+    entrances.push_back( c );
+}
+
+/// Walks one border of a cluster. Cells (x, y) along it are inside the
+/// cluster, (x + ox, y + oy) is the facing cell of the neighbor. Like astar,
+/// a diagonal step only needs the cell it lands on to be walkable, so the
+/// border can also be crossed diagonally, including at the cluster's corners.
+void scanBorder( const Graph & graph, const grid::Bitmap & gridData,
+                 grid::Coord first, grid::Coord step, int length, int ox,
+                 int oy, std::vector< grid::Coord > & outEntrances ) {
+    int runStart = -1;
+
+    for ( int i = 0; i <= length; i++ ) {
+        int x = first.x + step.x * i;
+        int y = first.y + step.y * i;
+
+        bool open = i < length && walkable( graph, gridData, x, y ) &&
+                    walkable( graph, gridData, x + ox, y + oy );
+
+        if ( open && runStart < 0 ) {
+            runStart = i;
+        } else if ( !open && runStart >= 0 ) {
+            int runLength = i - runStart;
+
+            if ( runLength < kSplitLength ) {
+                int mid = runStart + runLength / 2;
+                addEntrance( outEntrances,
+                             grid::Coord{ first.x + step.x * mid,
+                                          first.y + step.y * mid } );
+            } else {
+                int last = i - 1;
+                addEntrance( outEntrances,
+                             grid::Coord{ first.x + step.x * runStart,
+                                          first.y + step.y * runStart } );
+                addEntrance( outEntrances,
+                             grid::Coord{ first.x + step.x * last,
+                                          first.y + step.y * last } );
+            }
+
+            runStart = -1;
+        }
+    }
+
+    // a diagonal crossing needs its own entrance only when the other two
+    // cells of its 2x2 block are blocked, otherwise it goes around through a
+    // straight crossing. Past the ends of the border it leads into the
+    // cluster diagonal to this one.
+    for ( int i = 0; i < length; i++ ) {
+        int x = first.x + step.x * i;
+        int y = first.y + step.y * i;
+
+        if ( !walkable( graph, gridData, x, y ) ||
+             walkable( graph, gridData, x + ox, y + oy ) ) {
+            continue;
+        }
+
+        for ( int d = -1; d <= 1; d += 2 ) {
+            int jx = x + step.x * d;
+            int jy = y + step.y * d;
+
+            if ( walkable( graph, gridData, jx + ox, jy + oy ) &&
+                 !walkable( graph, gridData, jx, jy ) ) {
+                addEntrance( outEntrances, grid::Coord{ x, y } );
+            }
+        }
+    }
+}
+
+std::vector< grid::Coord > findEntrances( const Graph & graph,
+                                          const grid::Bitmap & gridData,
+                                          int cluster ) {
+    Bounds b = clusterBounds( graph, cluster );
+    int w = b.x1 - b.x0 + 1;
+    int h = b.y1 - b.y0 + 1;
+
+    std::vector< grid::Coord > entrances;
+
+    if ( b.x0 > 0 ) {
+        scanBorder( graph, gridData, { b.x0, b.y0 }, { 0, 1 }, h, -1, 0,
+                    entrances );
+    }
+    if ( b.x1 + 1 < graph.gridInfo.width ) {
+        scanBorder( graph, gridData, { b.x1, b.y0 }, { 0, 1 }, h, 1, 0,
+                    entrances );
+    }
+    if ( b.y0 > 0 ) {
+        scanBorder( graph, gridData, { b.x0, b.y0 }, { 1, 0 }, w, 0, -1,
+                    entrances );
+    }
+    if ( b.y1 + 1 < graph.gridInfo.height ) {
+        scanBorder( graph, gridData, { b.x0, b.y1 }, { 1, 0 }, w, 0, 1,
+                    entrances );
+    }
+
+    return entrances;
+}
+
+void computeDistances( Graph & graph, const grid::Bitmap & gridData,
+                       int cluster ) {
+    Cluster & c = graph.clusters[ cluster ];
+    size_t n = c.entrances.size();
+
+    c.distances.assign( n * n, -1 );
+
+    for ( size_t i = 0; i < n; i++ ) {
+        searchCluster( graph, gridData, cluster, c.entrances[ i ] );
+
+        for ( size_t j = 0; j < n; j++ ) {
+            int cost = cellCost( graph, cluster, c.entrances[ j ] );
+            c.distances[ i * n + j ] = cost == kInfinity ? -1 : cost;
+        }
+    }
+}
+
+bool sameEntrances( const std::vector< grid::Coord > & a,
+                    const std::vector< grid::Coord > & b ) {
+    return std::equal( a.begin(), a.end(), b.begin(), b.end(),
+                       []( grid::Coord p, grid::Coord q ) {
+                           return p.x == q.x && p.y == q.y;
+                       } );
+}
+
+void updateNodeIds( Graph & graph ) {
+    graph.nodeOffsets.resize( graph.clusters.size() );
+    graph.nodeClusters.clear();
+
+    int count = 0;
+    for ( size_t i = 0; i < graph.clusters.size(); i++ ) {
+        graph.nodeOffsets[ i ] = count;
+        count += graph.clusters[ i ].entrances.size();
+        graph.nodeClusters.resize( count, (int) i );
+    }
+}
+
+int findEntrance( const Graph & graph, int cluster, grid::Coord c ) {
+    const std::vector< grid::Coord > & entrances =
+        graph.clusters[ cluster ].entrances;
+    for ( size_t i = 0; i < entrances.size(); i++ ) {
+        if ( entrances[ i ].x == c.x && entrances[ i ].y == c.y ) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+} // namespace
+
+void build( Graph & graph, grid::Info gridInfo,
+            const grid::Bitmap & gridData, int clusterSize ) {
+    graph.gridInfo = gridInfo;
+    graph.clusterSize = clusterSize;
+    graph.clusterInfo.width =
+        ( gridInfo.width + clusterSize - 1 ) / clusterSize;
+    graph.clusterInfo.height =
+        ( gridInfo.height + clusterSize - 1 ) / clusterSize;
+
+    graph.clusters.assign( grid::size( graph.clusterInfo ), Cluster{} );
+
+    for ( Cluster & cluster : graph.clusters ) {
+        cluster.dirty = true;
+    }
+
+    refresh( graph, gridData );
+}
+
+void markDirty( Graph & graph, int x, int y ) {
+    if ( !grid::contains( graph.gridInfo, x, y ) ) {
+        return;
+    }
+    graph.clusters[ clusterOf( graph, { x, y } ) ].dirty = true;
+}
+
+void refresh( Graph & graph, const grid::Bitmap & gridData ) {
+    grid::Info & info = graph.clusterInfo;
+
+    // a changed cell can move the entrances on either side of a border or
+    // corner, so neighbors are rescanned too but only rebuilt when their
+    // entrances moved
+    std::vector< bool > rescan( graph.clusters.size(), false );
+
+    for ( size_t i = 0; i < graph.clusters.size(); i++ ) {
+        if ( !graph.clusters[ i ].dirty ) {
+            continue;
+        }
+
+        grid::Coord c = grid::coord( info, i );
+        rescan[ i ] = true;
+
+        for ( int j = 0; j < 8; j++ ) {
+            int nx = c.x + kNborOffsets[ j ].x;
+            int ny = c.y + kNborOffsets[ j ].y;
+            if ( grid::contains( info, nx, ny ) ) {
+                rescan[ grid::index( info, nx, ny ) ] = true;
+            }
+        }
+    }
+
+    bool changed = false;
+
+    for ( size_t i = 0; i < graph.clusters.size(); i++ ) {
+        if ( !rescan[ i ] ) {
+            continue;
+        }
+
+        Cluster & cluster = graph.clusters[ i ];
+        std::vector< grid::Coord > entrances =
+            findEntrances( graph, gridData, i );
+
+        if ( cluster.dirty || !sameEntrances( entrances, cluster.entrances ) ) {
+            cluster.entrances = std::move( entrances );
+            computeDistances( graph, gridData, i );
+            changed = true;
+        }
+
+        cluster.dirty = false;
+    }
+
+    if ( changed ) {
+        updateNodeIds( graph );
+    }
+}
+
+bool findRoute( Graph & graph, const grid::Bitmap & gridData,
+                grid::Coord start, grid::Coord end,
+                std::vector< grid::Coord > & outRoute ) {
+    outRoute.clear();
+
+    if ( !grid::contains( graph.gridInfo, start ) ||
+         !grid::contains( graph.gridInfo, end ) ) {
+        return false;
+    }
+
+    int startCluster = clusterOf( graph, start );
+    int endCluster = clusterOf( graph, end );
+
+    const std::vector< grid::Coord > & startEntrances =
+        graph.clusters[ startCluster ].entrances;
+    const std::vector< grid::Coord > & endEntrances =
+        graph.clusters[ endCluster ].entrances;
+
+    // connect start and end to their clusters
+    int direct = kInfinity;
+
+    searchCluster( graph, gridData, startCluster, start );
+    graph.startCosts.clear();
+    for ( grid::Coord e : startEntrances ) {
+        graph.startCosts.push_back( cellCost( graph, startCluster, e ) );
+    }
+    if ( startCluster == endCluster ) {
+        direct = cellCost( graph, startCluster, end );
+    }
+
+    searchCluster( graph, gridData, endCluster, end );
+    graph.endCosts.clear();
+    for ( grid::Coord e : endEntrances ) {
+        graph.endCosts.push_back( cellCost( graph, endCluster, e ) );
+    }
+
+    // abstract A*, start and end get the two ids after the entrances
+    int nodeCount = (int) graph.nodeClusters.size();
+    int startNode = nodeCount;
+    int endNode = nodeCount + 1;
+
+    auto coordOf = [ & ]( int node ) {
+        if ( node == startNode ) {
+            return start;
+        }
+        if ( node == endNode ) {
+            return end;
+        }
+        int cluster = graph.nodeClusters[ node ];
+        return graph.clusters[ cluster ]
+            .entrances[ node - graph.nodeOffsets[ cluster ] ];
+    };
+
+    graph.g.assign( nodeCount + 2, kInfinity );
+    graph.parents.assign( nodeCount + 2, -1 );
+    graph.open.clear();
+
+    auto relax = [ & ]( int from, int to, int cost ) {
+        int newG = graph.g[ from ] + cost;
+        if ( newG < graph.g[ to ] ) {
+            graph.g[ to ] = newG;
+            graph.parents[ to ] = from;
+            int h = astar::octileHeuristic( coordOf( to ), end );
+            pushOpen( graph.open, newG + h, to );
+        }
+    };
+
+    graph.g[ startNode ] = 0;
+    pushOpen( graph.open, astar::octileHeuristic( start, end ), startNode );
+
+    bool found = false;
+
+    while ( !graph.open.empty() ) {
+        auto [ f, node ] = popOpen( graph.open );
+
+        if ( node == endNode ) {
+            found = true;
+            break;
+        }
+
+        // stale entry
+        if ( f - astar::octileHeuristic( coordOf( node ), end ) >
+             graph.g[ node ] ) {
+            continue;
+        }
+
+        if ( node == startNode ) {
+            int offset = graph.nodeOffsets[ startCluster ];
+            for ( size_t i = 0; i < startEntrances.size(); i++ ) {
+                if ( graph.startCosts[ i ] != kInfinity ) {
+                    relax( node, offset + i, graph.startCosts[ i ] );
+                }
+            }
+            if ( direct != kInfinity ) {
+                relax( node, endNode, direct );
+            }
+            continue;
+        }
+
+        int cluster = graph.nodeClusters[ node ];
+        int local = node - graph.nodeOffsets[ cluster ];
+        const Cluster & c = graph.clusters[ cluster ];
+        size_t n = c.entrances.size();
+        grid::Coord coord = c.entrances[ local ];
+
+        // through the cluster
+        for ( size_t i = 0; i < n; i++ ) {
+            int cost = c.distances[ local * n + i ];
+            if ( cost > 0 ) {
+                relax( node, graph.nodeOffsets[ cluster ] + i, cost );
+            }
+        }
+
+        // across the border, straight or diagonally
+        for ( int i = 0; i < 8; i++ ) {
+            grid::Coord nbor{ coord.x + kNborOffsets[ i ].x,
+                              coord.y + kNborOffsets[ i ].y };
+
+            if ( !walkable( graph, gridData, nbor.x, nbor.y ) ) {
+                continue;
+            }
+
+            int nborCluster = clusterOf( graph, nbor );
+            if ( nborCluster == cluster ) {
+                continue;
+            }
+
+            int entrance = findEntrance( graph, nborCluster, nbor );
+            if ( entrance >= 0 ) {
+                relax( node, graph.nodeOffsets[ nborCluster ] + entrance,
+                       kNborWeights[ i ] );
+            }
+        }
+
+        // into the end
+        if ( cluster == endCluster && graph.endCosts[ local ] != kInfinity ) {
+            relax( node, endNode, graph.endCosts[ local ] );
+        }
+    }
+
+    if ( !found ) {
+        return false;
+    }
+
+    int node = endNode;
+    while ( node != startNode ) {
+        int parent = graph.parents[ node ];
+
+        // skip the near side of border crossings, the leg to the far side
+        // covers it
+        bool crossing = parent != startNode && node != endNode &&
+                        graph.nodeClusters[ parent ] !=
+                            graph.nodeClusters[ node ];
+        outRoute.push_back( coordOf( node ) );
+        node = crossing ? graph.parents[ parent ] : parent;
+    }
+
+    std::reverse( outRoute.begin(), outRoute.end() );
+
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+bool sameGraph( const Graph & a, const Graph & b ) {
+    if ( a.clusters.size() != b.clusters.size() ||
+         a.nodeOffsets != b.nodeOffsets || a.nodeClusters != b.nodeClusters ) {
+        return false;
+    }
+
+    for ( size_t i = 0; i < a.clusters.size(); i++ ) {
+        const Cluster & p = a.clusters[ i ];
+        const Cluster & q = b.clusters[ i ];
+        if ( !sameEntrances( p.entrances, q.entrances ) ||
+             p.distances != q.distances || p.dirty || q.dirty ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Random wall edits, marked dirty and refreshed, leave the same graph as a
+/// fresh build. Routes on it reach the end exactly when astar does, and every
+/// leg of them is a search astar can finish.
+void testRefresh() {
+    grid::Info info{ 61, 45 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    std::mt19937 rng( 9 );
+    for ( int y = 0; y < info.height; y++ ) {
+        for ( int x = 0; x < info.width; x++ ) {
+            grid::set( data, x, y, rng() % 4 == 0 );
+        }
+    }
+
+    const int clusterSize = 8;
+
+    Graph graph;
+    build( graph, info, data, clusterSize );
+
+    Graph fresh;
+    astar::SearchContext context;
+    astar::Path path;
+    std::vector< grid::Coord > route;
+
+    auto randomCell = [ & ]() {
+        return grid::Coord{ int( rng() % info.width ),
+                            int( rng() % info.height ) };
+    };
+
+    auto reaches = [ & ]( grid::Coord start, grid::Coord end ) {
+        astar::shortestPath( context, info, data, start, end, 1000000, path );
+        grid::Coord last = path.points.back();
+        return last.x == end.x && last.y == end.y;
+    };
+
+    for ( int edit = 0; edit < 60; edit++ ) {
+        // a short wall or a gap, across cluster borders now and then
+        grid::Coord c = randomCell();
+        bool blocked = rng() % 2 == 0;
+        int length = 1 + rng() % 12;
+        bool horizontal = rng() % 2 == 0;
+        for ( int i = 0; i < length; i++ ) {
+            int x = horizontal ? c.x + i : c.x;
+            int y = horizontal ? c.y : c.y + i;
+            if ( grid::contains( info, x, y ) ) {
+                grid::set( data, x, y, blocked );
+                markDirty( graph, x, y );
+            }
+        }
+
+        refresh( graph, data );
+        build( fresh, info, data, clusterSize );
+        LOGGER_ASSERT( sameGraph( graph, fresh ) );
+
+        for ( int query = 0; query < 10; query++ ) {
+            grid::Coord start = randomCell();
+            grid::Coord end = randomCell();
+            if ( grid::test( data, start ) || grid::test( data, end ) ) {
+                continue;
+            }
+
+            bool found = findRoute( graph, data, start, end, route );
+            LOGGER_ASSERT( found == reaches( start, end ) );
+            if ( !found ) {
+                continue;
+            }
+
+            LOGGER_ASSERT( route.back().x == end.x &&
+                           route.back().y == end.y );
+
+            grid::Coord from = start;
+            for ( grid::Coord waypoint : route ) {
+                LOGGER_ASSERT( reaches( from, waypoint ) );
+                from = waypoint;
+            }
+        }
+    }
+}
+
+} // namespace
+
+void runTests() {
+    testRefresh();
+}
+
+} // namespace hpa
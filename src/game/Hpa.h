@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <utility>
+#include <vector>
+
+namespace hpa {
+
+/// A square block of the grid and the entrances on its borders
+struct Cluster {
+    std::vector< grid::Coord > entrances;
+
+    // entrance to entrance costs through the cluster (row major), -1 when
+    // there is no path that stays inside the cluster
+    std::vector< int > distances;
+
+    bool dirty;
+};
+
+/// Abstract graph over the collision bitmap, used to plan long routes cluster
+/// by cluster before refining them with astar
+struct Graph {
+    grid::Info gridInfo;
+    grid::Info clusterInfo;
+    int clusterSize;
+
+    std::vector< Cluster > clusters;
+
+    // abstract node ids are nodeOffsets[ cluster ] + entrance index
+    std::vector< int > nodeOffsets;
+    std::vector< int > nodeClusters;
+
+    // search scratch, kept around so queries don't allocate
+    std::vector< int > cellCosts;
+    std::vector< int > startCosts;
+    std::vector< int > endCosts;
+    std::vector< int > g;
+    std::vector< int > parents;
+    std::vector< std::pair< int, int > > open;
+};
+
+void build( Graph & graph, grid::Info gridInfo,
+            const grid::Bitmap & gridData, int clusterSize );
+
+/// Flags the cluster owning cell (x, y) for the next refresh
+void markDirty( Graph & graph, int x, int y );
+
+/// Rebuilds dirty clusters, and the entrances of their neighbors
+void refresh( Graph & graph, const grid::Bitmap & gridData );
+
+/// Plans a route of waypoints (excluding start, ending at end) through the
+/// abstract graph. Consecutive waypoints are at most one cluster apart, so
+/// each leg is a short astar query.
+bool findRoute( Graph & graph, const grid::Bitmap & gridData,
+                grid::Coord start, grid::Coord end,
+                std::vector< grid::Coord > & outRoute );
+
+void runTests();
+
+} // namespace hpa
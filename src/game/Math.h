@@ -3,6 +3,8 @@
 #include <glm/mat4x4.hpp>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+
+#include <cstdint>
 #include <vector>
 
 #include "Rect.h"
@@ -42,6 +44,14 @@ bool contains( Rect rect, int x, int y );
 
 void runTests();
 
+/// xorshift32 step, state must not be 0
+inline uint32_t xorshift32( uint32_t & state ) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
 struct Poly3 {
     float k[ 4 ];
 };
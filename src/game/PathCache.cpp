@@ -0,0 +1,208 @@
+#include "PathCache.h"
+
+#include "Logging.h"
+
+namespace pathCache {
+
+// past this many indexed cells the cache starts over
+static const size_t kCellsMax = 1 << 18;
+
+namespace {
+
+uint64_t key( grid::Info gridInfo, grid::Coord goal, grid::Coord cell ) {
+    uint64_t goalIndex = grid::index( gridInfo, goal );
+    return goalIndex * grid::size( gridInfo ) + grid::index( gridInfo, cell );
+}
+
+void clear( Cache & cache ) {
+    cache.points.clear();
+    cache.entries.clear();
+    cache.cells.clear();
+}
+
+} // namespace
+
+void sync( Cache & cache, unsigned version ) {
+    if ( cache.version != version ) {
+        clear( cache );
+        cache.version = version;
+    }
+}
+
+bool find( Cache & cache, astar::SearchContext & context,
+           grid::Info gridInfo, const grid::Bitmap & gridData,
+           grid::Coord start, grid::Coord end,
+           std::vector< grid::Coord > & outPoints ) {
+    auto it = cache.cells.find( key( gridInfo, end, start ) );
+    if ( it == cache.cells.end() ) {
+        cache.misses++;
+        return false;
+    }
+
+    Location location = it->second;
+    Entry entry = cache.entries[ location.entry ];
+    auto first = cache.points.begin() + entry.offset;
+
+    outPoints.clear();
+    outPoints.push_back( start );
+    if ( location.segment + 1 < entry.count ) {
+        grid::Coord segmentStart = first[ location.segment ];
+        grid::Coord segmentEnd = first[ location.segment + 1 ];
+
+        if ( !astar::lineOfSight( context, gridData, start, segmentEnd ) ) {
+            if ( !astar::lineOfSight( context, gridData, start,
+                                      segmentStart ) ) {
+                cache.misses++;
+                return false;
+            }
+            outPoints.push_back( segmentStart );
+        }
+
+        outPoints.insert( outPoints.end(), first + location.segment + 1,
+                          first + entry.count );
+    }
+
+    cache.hits++;
+    return true;
+}
+
+void insert( Cache & cache, grid::Info gridInfo, const grid::Coord * points,
+             size_t count ) {
+    if ( count < 2 ) {
+        return;
+    }
+
+    if ( cache.cells.size() > kCellsMax ) {
+        clear( cache );
+    }
+
+    size_t entryIndex = cache.entries.size();
+    cache.entries.push_back( Entry{ cache.points.size(), count } );
+    cache.points.insert( cache.points.end(), points, points + count );
+
+    grid::Coord goal = points[ count - 1 ];
+
+    // index every cell the segments cross, they can be at any angle
+    for ( size_t i = 0; i + 1 < count; i++ ) {
+        cache.lineCells.clear();
+        grid::appendLine( points[ i ], points[ i + 1 ], cache.lineCells );
+        cache.lineCells.pop_back();
+
+        for ( grid::Coord c : cache.lineCells ) {
+            cache.cells.emplace( key( gridInfo, goal, c ),
+                                 Location{ entryIndex, i } );
+        }
+    }
+
+    cache.cells.emplace( key( gridInfo, goal, goal ),
+                         Location{ entryIndex, count - 1 } );
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+/// A grid with a few walls to go around, and a smoothed path across it
+void makePath( grid::Info info, grid::Bitmap & data, grid::Coord start,
+               grid::Coord end, astar::SearchContext & context,
+               astar::Path & path ) {
+    grid::resize( data, info );
+    for ( int i = 0; i < 30; i++ ) {
+        grid::set( data, 15, i, true );
+        grid::set( data, 30, info.height - 1 - i, true );
+        grid::set( data, 45, 5 + i, true );
+    }
+
+    astar::shortestPath( context, info, data, start, end, 100000, path );
+    astar::smoothPath( context, data, path.points );
+}
+
+/// Every cell along a cached path gets a path to the same goal, each of its
+/// segments clear of walls
+void testSuffixReuse() {
+    grid::Info info{ 60, 40 };
+    grid::Bitmap data;
+    grid::Coord start{ 2, 2 };
+    grid::Coord end{ 57, 37 };
+
+    astar::SearchContext context;
+    astar::Path path;
+    makePath( info, data, start, end, context, path );
+    LOGGER_ASSERT( path.points.size() > 2 );
+
+    Cache cache;
+    sync( cache, 1 );
+    insert( cache, info, path.points.data(), path.points.size() );
+
+    std::vector< grid::Coord > points;
+    LOGGER_ASSERT( find( cache, context, info, data, start, end, points ) );
+    LOGGER_ASSERT( points.size() == path.points.size() );
+
+    std::vector< grid::Coord > cells;
+    for ( size_t i = 0; i + 1 < path.points.size(); i++ ) {
+        grid::appendLine( path.points[ i ], path.points[ i + 1 ], cells );
+    }
+
+    size_t hits = 0;
+    for ( grid::Coord cell : cells ) {
+        if ( !find( cache, context, info, data, cell, end, points ) ) {
+            continue;
+        }
+        hits++;
+
+        LOGGER_ASSERT( points.front().x == cell.x &&
+                       points.front().y == cell.y );
+        LOGGER_ASSERT( points.back().x == end.x && points.back().y == end.y );
+        LOGGER_ASSERT( points.size() <= path.points.size() + 1 );
+        for ( size_t i = 1; i < points.size(); i++ ) {
+            LOGGER_ASSERT( astar::lineOfSight( context, data, points[ i - 1 ],
+                                               points[ i ] ) );
+        }
+    }
+
+    // only corner cases may miss
+    LOGGER_ASSERT( hits * 10 >= cells.size() * 9 );
+
+    // same cell toward another goal, and a cell off the path
+    LOGGER_ASSERT( !find( cache, context, info, data, start,
+                          grid::Coord{ 57, 2 }, points ) );
+    LOGGER_ASSERT( !find( cache, context, info, data, grid::Coord{ 2, 37 },
+                          end, points ) );
+}
+
+/// Paths stay while the version does and are dropped once it changes
+void testVersionInvalidation() {
+    grid::Info info{ 60, 40 };
+    grid::Bitmap data;
+    grid::Coord start{ 2, 2 };
+    grid::Coord end{ 57, 37 };
+
+    astar::SearchContext context;
+    astar::Path path;
+    makePath( info, data, start, end, context, path );
+
+    Cache cache;
+    sync( cache, 3 );
+    insert( cache, info, path.points.data(), path.points.size() );
+
+    std::vector< grid::Coord > points;
+    sync( cache, 3 );
+    LOGGER_ASSERT( find( cache, context, info, data, start, end, points ) );
+
+    sync( cache, 4 );
+    LOGGER_ASSERT( cache.entries.empty() && cache.cells.empty() );
+    LOGGER_ASSERT( !find( cache, context, info, data, start, end, points ) );
+
+    // paths cached on the new version are found again
+    insert( cache, info, path.points.data(), path.points.size() );
+    LOGGER_ASSERT( find( cache, context, info, data, start, end, points ) );
+}
+
+} // namespace
+
+void runTests() {
+    testSuffixReuse();
+    testVersionInvalidation();
+}
+
+} // namespace pathCache
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Grid.h"
+#include "GridAstar.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace pathCache {
+
+struct Entry {
+    size_t offset;
+    size_t count;
+};
+
+/// Where a cell lies on a cached path, the cell is on the segment from
+/// points[ segment ] to points[ segment + 1 ]
+struct Location {
+    size_t entry;
+    size_t segment;
+};
+
+/// Complete paths found against one version of the collision grid. Any cell
+/// along a cached path can reuse the rest of it, since every suffix of a
+/// shortest path is a shortest path.
+struct Cache {
+    unsigned version = 0;
+
+    std::vector< grid::Coord > points;
+    std::vector< Entry > entries;
+
+    // keyed by ( goal cell, path cell )
+    std::unordered_map< uint64_t, Location > cells;
+
+    // cells of the segment being indexed
+    std::vector< grid::Coord > lineCells;
+
+    size_t hits = 0;
+    size_t misses = 0;
+};
+
+/// Drops every path when version differs from the cached one
+void sync( Cache & cache, unsigned version );
+
+/// Copies the cached path from start to end into outPoints. A cell only
+/// touching its segment at a corner may not see the segment's end, such hits
+/// go through the segment's start or miss.
+bool find( Cache & cache, astar::SearchContext & context,
+           grid::Info gridInfo, const grid::Bitmap & gridData,
+           grid::Coord start, grid::Coord end,
+           std::vector< grid::Coord > & outPoints );
+
+/// Caches a path that reaches its goal, the last point
+void insert( Cache & cache, grid::Info gridInfo, const grid::Coord * points,
+             size_t count );
+
+void runTests();
+
+} // namespace pathCache
@@ -1,16 +1,260 @@
 #include "PathGrid.h"
 
+#include "Logging.h"
+#include "WorkerPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <limits>
+#include <queue>
+#include <random>
+#include <utility>
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
 
 namespace pathGrid {
 
-void iterate( Info info, grid::Coord coord ) {
-    size_t index = grid::index( info.gridInfo, coord );
+static const Cost kUnreachable = std::numeric_limits< Cost >::max();
+
+// grids smaller than this aren't worth starting sweep threads for
+static const size_t kParallelCellsMin = 1 << 16;
+static const int kSweepThreadsMax = 8;
+
+namespace {
+
+using CostCell = std::pair< int, size_t >;
+using CostQueue = std::priority_queue< CostCell, std::vector< CostCell >,
+                                       std::greater< CostCell > >;
+
+/// Neighbors in the same order iterate uses, i is the field bit 3 - i
+bool neighbor( Info info, grid::Coord coord, int i, size_t * outIndex,
+               grid::Coord * outCoord = nullptr ) {
+    static const int kOffsetsX[ 4 ] = { 1, -1, 0, 0 };
+    static const int kOffsetsY[ 4 ] = { 0, 0, 1, -1 };
+
+    grid::Coord n{ coord.x + kOffsetsX[ i ], coord.y + kOffsetsY[ i ] };
+    if ( !grid::contains( info.gridInfo, n ) ) {
+        return false;
+    }
+
+    *outIndex = grid::index( info.gridInfo, n );
+    if ( outCoord ) {
+        *outCoord = n;
+    }
+    return true;
+}
+
+bool masked( Info info, size_t index ) {
+    return grid::test( *info.mask, grid::coord( info.gridInfo, index ) );
+}
+
+/// The field value iterate settles on, every neighbor with the lowest cost
+void updateField( Info info, size_t targetIndex, size_t index ) {
+    grid::Coord coord = grid::coord( info.gridInfo, index );
+
+    if ( index == targetIndex || grid::test( *info.mask, coord ) ) {
+        ( *info.field )[ index ] = 0;
+        return;
+    }
+
+    int cheapestCost = kUnreachable;
+    Vector cheapMask = 0;
+    for ( int i = 0; i < 4; i++ ) {
+        size_t ni;
+        if ( !neighbor( info, coord, i, &ni ) )
+            continue;
+
+        int cost = ( *info.costs )[ ni ];
+
+        if ( cost <= cheapestCost ) {
+            if ( cost != cheapestCost ) {
+                cheapMask = 0;
+            }
+
+            cheapestCost = cost;
+            cheapMask |= 1 << ( 3 - i );
+        }
+    }
+
+    ( *info.field )[ index ] = cheapMask;
+}
+
+/// Lowest neighbor cost plus a step
+Cost supportedCost( Info info, size_t index ) {
+    grid::Coord coord = grid::coord( info.gridInfo, index );
+
+    int best = kUnreachable;
+    for ( int i = 0; i < 4; i++ ) {
+        size_t ni;
+        if ( neighbor( info, coord, i, &ni ) ) {
+            best = std::min< int >( best, ( *info.costs )[ ni ] );
+        }
+    }
+
+    return best < kUnreachable ? best + 1 : kUnreachable;
+}
+
+// colour for sweeps that visit every cell, otherwise only cells with
+// ( x + y ) % 2 == colour are relaxed
+static const int kAllCells = -1;
+
+bool hasColour( int x, int y, int colour ) {
+    return colour == kAllCells || ( x + y ) % 2 == colour;
+}
+
+/// Relaxes cells [ x0, x1 ) of row y, returns where it stopped
+int relaxSpan( Info info, int y, int x0, int x1, int colour ) {
+    for ( int x = x0; x < x1; x++ ) {
+        if ( hasColour( x, y, colour ) ) {
+            iterate( info, grid::Coord{ x, y } );
+        }
+    }
+    return x1;
+}
+
+#if defined( __SSE2__ )
+
+/// Unsigned 16-bit min, SSE2 only has the signed one
+__m128i minU16( __m128i a, __m128i b ) {
+    const __m128i bias = _mm_set1_epi16( (short) 0x8000 );
+    return _mm_xor_si128( _mm_min_epi16( _mm_xor_si128( a, bias ),
+                                         _mm_xor_si128( b, bias ) ),
+                          bias );
+}
+
+__m128i select( __m128i condition, __m128i a, __m128i b ) {
+    return _mm_or_si128( _mm_and_si128( condition, a ),
+                         _mm_andnot_si128( condition, b ) );
+}
+
+/// iterate for eight cells at a time, branch free. Only for interior cells,
+/// every cell in [ x0, x1 ) needs all four neighbors. Returns where it
+/// stopped, the remainder is left for the scalar path.
+int relaxSpanSimd( Info info, int y, int x0, int x1, int colour ) {
+    Cost * costs = info.costs->data();
+    Vector * field = info.field->data();
+    int width = info.gridInfo.width;
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16( 1 );
+
+    // field bits in the same order iterate uses
+    const __m128i bitRight = _mm_set1_epi16( 0b1000 );
+    const __m128i bitLeft = _mm_set1_epi16( 0b0100 );
+    const __m128i bitDown = _mm_set1_epi16( 0b0010 );
+    const __m128i bitUp = _mm_set1_epi16( 0b0001 );
+
+    // lane i picks mask bit i
+    const __m128i laneBits = _mm_setr_epi16( 1, 2, 4, 8, 16, 32, 64, 128 );
+
+    // lanes of the wanted colour, for a span starting on an even x
+    __m128i colourLanes = _mm_set1_epi16( -1 );
+    if ( colour != kAllCells ) {
+        short even = ( y % 2 == colour ) ? -1 : 0;
+        short odd = ~even;
+        colourLanes =
+            _mm_setr_epi16( even, odd, even, odd, even, odd, even, odd );
+        if ( x0 % 2 != 0 ) {
+            colourLanes = _mm_xor_si128( colourLanes, _mm_set1_epi16( -1 ) );
+        }
+    }
+
+    int x = x0;
+    for ( ; x + 8 <= x1; x += 8 ) {
+        size_t index = y * width + x;
+        const Cost * c = costs + index;
+
+        __m128i right = _mm_loadu_si128( (const __m128i *) ( c + 1 ) );
+        __m128i left = _mm_loadu_si128( (const __m128i *) ( c - 1 ) );
+        __m128i down = _mm_loadu_si128( (const __m128i *) ( c + width ) );
+        __m128i up = _mm_loadu_si128( (const __m128i *) ( c - width ) );
+
+        __m128i cheapest = minU16( minU16( right, left ), minU16( down, up ) );
+
+        __m128i bits = _mm_and_si128( _mm_cmpeq_epi16( right, cheapest ),
+                                      bitRight );
+        bits = _mm_or_si128( bits, _mm_and_si128(
+                                       _mm_cmpeq_epi16( left, cheapest ),
+                                       bitLeft ) );
+        bits = _mm_or_si128( bits, _mm_and_si128(
+                                       _mm_cmpeq_epi16( down, cheapest ),
+                                       bitDown ) );
+        bits = _mm_or_si128(
+            bits, _mm_and_si128( _mm_cmpeq_epi16( up, cheapest ), bitUp ) );
 
+        // cheapest + 1, staying at unreachable
+        __m128i cost = _mm_adds_epu16( cheapest, one );
+
+        // masked cells and cells of the other colour keep what they had
+        __m128i blocked = _mm_set1_epi16( grid::rowBits( *info.mask, x, y ) );
+        __m128i open =
+            _mm_cmpeq_epi16( _mm_and_si128( blocked, laneBits ), zero );
+        open = _mm_and_si128( open, colourLanes );
+
+        __m128i oldCost = _mm_loadu_si128( (const __m128i *) ( c ) );
+        _mm_storeu_si128( (__m128i *) ( costs + index ),
+                          select( open, cost, oldCost ) );
+
+        __m128i oldField = _mm_unpacklo_epi8(
+            _mm_loadl_epi64( (const __m128i *) ( field + index ) ), zero );
+
+        __m128i newField = select( open, bits, oldField );
+        _mm_storel_epi64( (__m128i *) ( field + index ),
+                          _mm_packus_epi16( newField, zero ) );
+    }
+
+    return x;
+}
+
+#endif
+
+/// The kernel stores whole vectors, cells of the other colour get their own
+/// values back. Rows another thread reads from have to pass vectorize false.
+void relaxRow( Info info, grid::Coord target, int y, int colour,
+               bool vectorize ) {
+    int width = info.gridInfo.width;
+    int height = info.gridInfo.height;
+
+    // the target keeps its cost, so its row is done in two spans
+    int spans[ 2 ][ 2 ] = { { 0, width }, { width, width } };
+    if ( y == target.y ) {
+        spans[ 0 ][ 1 ] = target.x;
+        spans[ 1 ][ 0 ] = target.x + 1;
+    }
+
+    for ( auto [ x0, x1 ] : spans ) {
+        if ( y == 0 || y == height - 1 ) {
+            relaxSpan( info, y, x0, x1, colour );
+            continue;
+        }
+
+        // the first and last column miss a neighbor
+        int innerBegin = std::min( std::max( x0, 1 ), x1 );
+        int innerEnd = std::max( innerBegin, std::min( x1, width - 1 ) );
+
+        int x = relaxSpan( info, y, x0, innerBegin, colour );
+#if defined( __SSE2__ )
+        if ( vectorize ) {
+            x = relaxSpanSimd( info, y, x, innerEnd, colour );
+        }
+#endif
+        relaxSpan( info, y, x, x1, colour );
+    }
+}
+
+} // namespace
+
+void iterate( Info info, grid::Coord coord ) {
     // skip things that are masked out
-    if ( ( *info.mask )[ index ] )
+    if ( grid::test( *info.mask, coord ) )
         return;
 
+    size_t index = grid::index( info.gridInfo, coord );
+
     // choose the lowest cost
     grid::Coord ns[ 4 ];
 
@@ -24,8 +268,7 @@ void iterate( Info info, grid::Coord coord ) {
     ns[ 2 ].y += 1;
     ns[ 3 ].y -= 1;
 
-    int intMax = std::numeric_limits< int >::max();
-    int cheapestCost = intMax;
+    int cheapestCost = kUnreachable;
     unsigned char cheapMask = 0;
     for ( int i = 0; i < 4; i++ ) {
         grid::Coord n = ns[ i ];
@@ -47,15 +290,407 @@ void iterate( Info info, grid::Coord coord ) {
     }
 
     // prevent overflow
-    if ( cheapestCost < intMax ) {
+    if ( cheapestCost < kUnreachable ) {
         ( *info.costs )[ index ] = cheapestCost + 1;
     } else {
-        ( *info.costs )[ index ] = intMax;
+        ( *info.costs )[ index ] = kUnreachable;
     }
 
     ( *info.field )[ index ] = cheapMask;
 }
 
+void relax( Info info, grid::Coord target ) {
+    for ( int y = 0; y < info.gridInfo.height; y++ ) {
+        relaxRow( info, target, y, kAllCells, true );
+    }
+}
+
+void relaxParallel( Info info, grid::Coord target, int bandCount ) {
+    int height = info.gridInfo.height;
+    bandCount = std::clamp( bandCount, 1, std::max( height, 1 ) );
+
+    // a run per colour, the other colour reads what a run wrote
+    for ( int colour = 0; colour < 2; colour++ ) {
+        workerPool::run( bandCount, [ & ]( int band ) {
+            int y0 = height * band / bandCount;
+            int y1 = height * ( band + 1 ) / bandCount;
+
+            for ( int y = y0; y < y1; y++ ) {
+                bool inner = y != y0 && y != y1 - 1;
+                relaxRow( info, target, y, colour, inner );
+            }
+        } );
+    }
+}
+
+void relaxScalar( Info info, grid::Coord target ) {
+    size_t targetIndex = grid::index( info.gridInfo, target );
+
+    for ( size_t i = 0; i < grid::size( info.gridInfo ); i++ ) {
+        if ( i != targetIndex ) {
+            iterate( info, grid::coord( info.gridInfo, i ) );
+        }
+    }
+}
+
+/// Bilinear cost at a continuous position, false if any corner is
+/// unreachable
+bool sampleCost( grid::Info gridInfo, const std::vector< Cost > & costs,
+                 float x, float y, float * outCost ) {
+    // cell centers sit at + 0.5
+    float u = x - 0.5f;
+    float v = y - 0.5f;
+    int x0 = std::floor( u );
+    int y0 = std::floor( v );
+    float fx = u - x0;
+    float fy = v - y0;
+
+    int corners[ 4 ];
+    for ( int i = 0; i < 4; i++ ) {
+        int cx = std::clamp( x0 + i % 2, 0, gridInfo.width - 1 );
+        int cy = std::clamp( y0 + i / 2, 0, gridInfo.height - 1 );
+        corners[ i ] = costs[ grid::index( gridInfo, cx, cy ) ];
+
+        if ( corners[ i ] == kUnreachable ) {
+            return false;
+        }
+    }
+
+    float top = corners[ 0 ] + fx * ( corners[ 1 ] - corners[ 0 ] );
+    float bottom = corners[ 2 ] + fx * ( corners[ 3 ] - corners[ 2 ] );
+    *outCost = top + fy * ( bottom - top );
+    return true;
+}
+
+bool sampleGradient( grid::Info gridInfo, const std::vector< Cost > & costs,
+                     float x, float y, float * outX, float * outY ) {
+    // central differences a cell apart, so ridges of the field cancel out.
+    // Next to walls the samples would reach across them, leave those cells
+    // to the 4-bit field.
+    float left, right, up, down;
+    if ( !sampleCost( gridInfo, costs, x - 1.0f, y, &left ) ||
+         !sampleCost( gridInfo, costs, x + 1.0f, y, &right ) ||
+         !sampleCost( gridInfo, costs, x, y - 1.0f, &up ) ||
+         !sampleCost( gridInfo, costs, x, y + 1.0f, &down ) ) {
+        return false;
+    }
+
+    float gx = right - left;
+    float gy = down - up;
+
+    float length = std::sqrt( gx * gx + gy * gy );
+    if ( length < 1e-3f ) {
+        return false;
+    }
+
+    *outX = -gx / length;
+    *outY = -gy / length;
+    return true;
+}
+
+void build( Info info, grid::Coord target ) {
+    std::vector< Cost > & costs = *info.costs;
+
+    size_t gridSize = grid::size( info.gridInfo );
+    size_t targetIndex = grid::index( info.gridInfo, target );
+
+    costs.assign( gridSize, kUnreachable );
+    info.field->assign( gridSize, 0 );
+
+    // every step costs the same, so a plain breadth first wavefront
+    std::vector< size_t > frontier;
+    frontier.reserve( gridSize );
+    frontier.push_back( targetIndex );
+    costs[ targetIndex ] = 0;
+
+    for ( size_t head = 0; head < frontier.size(); head++ ) {
+        size_t index = frontier[ head ];
+        grid::Coord coord = grid::coord( info.gridInfo, index );
+
+        // costs past this saturate to unreachable, as they do in iterate
+        if ( costs[ index ] + 1 >= kUnreachable )
+            break;
+
+        for ( int i = 0; i < 4; i++ ) {
+            size_t ni;
+            grid::Coord n;
+            if ( !neighbor( info, coord, i, &ni, &n ) )
+                continue;
+
+            if ( costs[ ni ] != kUnreachable || grid::test( *info.mask, n ) )
+                continue;
+
+            costs[ ni ] = costs[ index ] + 1;
+            frontier.push_back( ni );
+        }
+    }
+
+    // costs are converged, so a sweep only fills in the field
+    int threadCount =
+        std::min( workerPool::threadCount() + 1, kSweepThreadsMax );
+    if ( gridSize >= kParallelCellsMin && threadCount > 1 ) {
+        relaxParallel( info, target, threadCount );
+    } else {
+        relax( info, target );
+    }
+}
+
+void update( Info info, grid::Coord target,
+             const std::vector< size_t > & changedCells ) {
+    std::vector< Cost > & costs = *info.costs;
+
+    size_t targetIndex = grid::index( info.gridInfo, target );
+
+    // cells whose cost changed, their fields and their neighbors' need redoing
+    std::vector< size_t > touched;
+    std::vector< size_t > reseed;
+    CostQueue queue;
+
+    for ( size_t index : changedCells ) {
+        if ( index == targetIndex )
+            continue;
+
+        touched.push_back( index );
+
+        if ( masked( info, index ) ) {
+            if ( costs[ index ] != kUnreachable ) {
+                queue.push( CostCell{ costs[ index ], index } );
+                costs[ index ] = kUnreachable;
+            }
+        } else {
+            reseed.push_back( index );
+        }
+    }
+
+    // raise: in order of old cost, drop every cell that has lost all of its
+    // neighbors one step closer to the target
+    while ( !queue.empty() ) {
+        auto [ oldCost, index ] = queue.top();
+        queue.pop();
+
+        grid::Coord coord = grid::coord( info.gridInfo, index );
+        for ( int i = 0; i < 4; i++ ) {
+            size_t ni;
+            if ( !neighbor( info, coord, i, &ni ) )
+                continue;
+
+            if ( ni == targetIndex || costs[ ni ] != oldCost + 1 ||
+                 masked( info, ni ) )
+                continue;
+
+            if ( supportedCost( info, ni ) == oldCost + 1 )
+                continue;
+
+            queue.push( CostCell{ costs[ ni ], ni } );
+            costs[ ni ] = kUnreachable;
+            touched.push_back( ni );
+            reseed.push_back( ni );
+        }
+    }
+
+    // lower: cost the dropped and opened cells from the valid cells around
+    // them and spread any improvement outward
+    for ( size_t index : reseed ) {
+        costs[ index ] = supportedCost( info, index );
+        if ( costs[ index ] != kUnreachable ) {
+            queue.push( CostCell{ costs[ index ], index } );
+        }
+    }
+
+    while ( !queue.empty() ) {
+        auto [ cost, index ] = queue.top();
+        queue.pop();
+
+        if ( cost != costs[ index ] )
+            continue;
+
+        grid::Coord coord = grid::coord( info.gridInfo, index );
+        for ( int i = 0; i < 4; i++ ) {
+            size_t ni;
+            if ( !neighbor( info, coord, i, &ni ) )
+                continue;
+
+            if ( ni == targetIndex || cost + 1 >= costs[ ni ] ||
+                 masked( info, ni ) )
+                continue;
+
+            costs[ ni ] = cost + 1;
+            queue.push( CostCell{ cost + 1, ni } );
+            touched.push_back( ni );
+        }
+    }
+
+    for ( size_t index : touched ) {
+        updateField( info, targetIndex, index );
+
+        grid::Coord coord = grid::coord( info.gridInfo, index );
+        for ( int i = 0; i < 4; i++ ) {
+            size_t ni;
+            if ( neighbor( info, coord, i, &ni ) ) {
+                updateField( info, targetIndex, ni );
+            }
+        }
+    }
+}
+
 void iterateField( Info info ) {}
 
+static void testRelax() {
+    grid::Info gridInfo{ 67, 53 };
+    size_t gridSize = grid::size( gridInfo );
+    grid::Coord target{ 30, 20 };
+
+    std::mt19937 rng( 7 );
+    grid::Bitmap mask;
+    grid::resize( mask, gridInfo );
+    for ( int y = 0; y < gridInfo.height; y++ ) {
+        for ( int x = 0; x < gridInfo.width; x++ ) {
+            grid::set( mask, x, y, rng() % 5 == 0 );
+        }
+    }
+
+    std::vector< Cost > costs;
+    std::vector< Vector > field;
+    build( Info{ gridInfo, &mask, &costs, &field, 0 }, target );
+
+    // build has to be a fixed point of iterate
+    std::vector< Cost > fixedCosts = costs;
+    std::vector< Vector > fixedField = field;
+    relaxScalar( Info{ gridInfo, &mask, &fixedCosts, &fixedField, 0 }, target );
+    LOGGER_ASSERT( fixedCosts == costs );
+    LOGGER_ASSERT( fixedField == field );
+
+    // every sweep has to settle on what build computes
+    for ( int sweep = 0; sweep < 4; sweep++ ) {
+        std::vector< Cost > sweptCosts( gridSize, kUnreachable );
+        std::vector< Vector > sweptField( gridSize, 0 );
+        sweptCosts[ grid::index( gridInfo, target ) ] = 0;
+
+        Info info{ gridInfo, &mask, &sweptCosts, &sweptField, 0 };
+        for ( size_t i = 0; i < gridSize; i++ ) {
+            std::vector< Cost > before = sweptCosts;
+            if ( sweep == 0 ) {
+                relaxScalar( info, target );
+            } else if ( sweep == 1 ) {
+                relax( info, target );
+            } else {
+                // one band and several bands
+                relaxParallel( info, target, sweep == 2 ? 1 : 5 );
+            }
+            if ( before == sweptCosts ) {
+                break;
+            }
+        }
+
+        LOGGER_ASSERT( sweptCosts == costs );
+        LOGGER_ASSERT( sweptField == field );
+    }
+}
+
+/// Random wall edits, some walling off whole regions and some opening them
+/// again, repaired with update have to match a fresh build every time
+static void testUpdate() {
+    grid::Info gridInfo{ 61, 47 };
+    grid::Coord target{ 25, 30 };
+    size_t targetIndex = grid::index( gridInfo, target );
+
+    std::mt19937 rng( 11 );
+    grid::Bitmap mask;
+    grid::resize( mask, gridInfo );
+    for ( int y = 0; y < gridInfo.height; y++ ) {
+        for ( int x = 0; x < gridInfo.width; x++ ) {
+            grid::set( mask, x, y, rng() % 6 == 0 );
+        }
+    }
+    grid::set( mask, target.x, target.y, false );
+
+    std::vector< Cost > costs;
+    std::vector< Vector > field;
+    Info info{ gridInfo, &mask, &costs, &field, 0 };
+    build( info, target );
+
+    std::vector< Cost > freshCosts;
+    std::vector< Vector > freshField;
+    std::vector< size_t > changedCells;
+
+    for ( int edit = 0; edit < 200; edit++ ) {
+        // a long thin wall or a small block, set or cleared
+        bool wide = rng() % 2 == 0;
+        int w = wide ? 1 + rng() % 30 : 1 + rng() % 4;
+        int h = wide ? 1 + rng() % 2 : 1 + rng() % 4;
+        if ( rng() % 2 == 0 ) {
+            std::swap( w, h );
+        }
+        int x0 = rng() % gridInfo.width;
+        int y0 = rng() % gridInfo.height;
+        bool blocked = rng() % 3 != 0;
+
+        changedCells.clear();
+        for ( int y = y0; y < std::min( y0 + h, gridInfo.height ); y++ ) {
+            for ( int x = x0; x < std::min( x0 + w, gridInfo.width ); x++ ) {
+                size_t i = grid::index( gridInfo, x, y );
+                if ( i != targetIndex && grid::test( mask, x, y ) != blocked ) {
+                    grid::set( mask, x, y, blocked );
+                    changedCells.push_back( i );
+                }
+            }
+        }
+
+        update( info, target, changedCells );
+        build( Info{ gridInfo, &mask, &freshCosts, &freshField, 0 }, target );
+
+        LOGGER_ASSERT( costs == freshCosts );
+        LOGGER_ASSERT( field == freshField );
+    }
+}
+
+static void benchmarkRelax() {
+    grid::Info gridInfo{ 1600 / 4, 1200 / 4 };
+    grid::Coord target{ gridInfo.width / 2, gridInfo.height / 2 };
+
+    grid::Bitmap mask;
+    grid::resize( mask, gridInfo );
+    for ( int y = 0; y < gridInfo.height - 10; y++ ) {
+        grid::set( mask, gridInfo.width / 4, y, true );
+    }
+
+    std::vector< Cost > costs;
+    std::vector< Vector > field;
+    Info info{ gridInfo, &mask, &costs, &field, 0 };
+    build( info, target );
+
+    const int runs = 20;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for ( int i = 0; i < runs; i++ ) {
+        relaxScalar( info, target );
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for ( int i = 0; i < runs; i++ ) {
+        relax( info, target );
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    int threadCount = workerPool::threadCount() + 1;
+    for ( int i = 0; i < runs; i++ ) {
+        relaxParallel( info, target, threadCount );
+    }
+    auto t3 = std::chrono::steady_clock::now();
+
+    float scalarMs =
+        std::chrono::duration< float, std::milli >( t1 - t0 ).count();
+    float simdMs =
+        std::chrono::duration< float, std::milli >( t2 - t1 ).count();
+    float parallelMs =
+        std::chrono::duration< float, std::milli >( t3 - t2 ).count();
+    DEBUG_LOG() << "relax 400x300: scalar " << scalarMs / runs
+                << " ms, simd " << simdMs / runs << " ms, " << threadCount
+                << " threads " << parallelMs / runs << " ms" << std::endl;
+}
+
+void runTests() {
+    testRelax();
+    testUpdate();
+    benchmarkRelax();
+}
+
 } // namespace pathGrid
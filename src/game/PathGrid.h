@@ -8,19 +8,56 @@ namespace pathGrid {
 
 using Vector = unsigned char;
 
+/// Steps to the target, saturating at the unreachable value 0xffff
+using Cost = uint16_t;
+
+/// costs and field are row major, the relaxation kernel sweeps whole rows
 struct Info {
     grid::Info gridInfo;
-    std::vector< int > * mask;
-    std::vector< int > * costs;
+    const grid::Bitmap * mask;
+    std::vector< Cost > * costs;
     std::vector< Vector > * field;
 
     size_t iterationIndex;
 };
 
+/// One relaxation step for a cell, repeated sweeps converge to what build
+/// computes directly
 void iterate( Info info, grid::Coord coord );
 
+/// One relaxation sweep over every cell but target, row by row. Uses the SSE2
+/// row kernel for eight cells at a time when available, at a fixed point it
+/// only refreshes the field.
+void relax( Info info, grid::Coord target );
+
+/// Red-black sweep, the cells with even x + y first and then the rest. Cells
+/// of one colour only read the other, so bandCount horizontal bands of rows
+/// run on the worker pool, one run per colour. The result doesn't depend on
+/// bandCount.
+void relaxParallel( Info info, grid::Coord target, int bandCount );
+
+/// Same sweep as relax, through iterate one cell at a time
+void relaxScalar( Info info, grid::Coord target );
+
+/// Downhill direction of costs at a continuous position, from central
+/// differences of the bilinearly interpolated costs. Returns false next to
+/// walls and where there is no slope to follow.
+bool sampleGradient( grid::Info gridInfo, const std::vector< Cost > & costs,
+                     float x, float y, float * outX, float * outY );
+
+/// Fills in converged costs (steps to target) and field with a wavefront from
+/// target, resizing both to the grid
+void build( Info info, grid::Coord target );
+
+/// Repairs converged costs and field after the mask changed at changedCells,
+/// only touching the cells whose cost depended on them
+void update( Info info, grid::Coord target,
+             const std::vector< size_t > & changedCells );
+
 void iterateChunk( Info info );
 
 void iterateField( Info info );
 
+void runTests();
+
 } // namespace pathGrid
@@ -0,0 +1,295 @@
+#include "PathQuery.h"
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+
+namespace pathQuery {
+
+static const size_t kWorkerCountMax = 8;
+
+// below this many queries per worker the thread start up isn't worth it
+static const size_t kWorkerQueriesMin = 16;
+
+namespace {
+
+size_t workerCount( size_t queryCount ) {
+    size_t count = std::thread::hardware_concurrency();
+    count = std::clamp< size_t >( count, 1, kWorkerCountMax );
+    count = std::min( count, queryCount / kWorkerQueriesMin );
+    return std::max< size_t >( count, 1 );
+}
+
+/// Hands a finished search's smoothed path to the worker's own arena, until
+/// collect packs them
+void finish( Worker & worker, const grid::Bitmap & gridData,
+             grid::Info gridInfo ) {
+    astar::finishSearch( worker.context, worker.search, gridInfo,
+                         worker.path );
+    astar::smoothPath( worker.context, gridData, worker.path.points );
+
+    std::vector< grid::Coord > & points = worker.path.points;
+    worker.finished.push_back( worker.query );
+    worker.results.push_back( Result{ worker.points.size(), points.size() } );
+    worker.points.insert( worker.points.end(), points.begin(), points.end() );
+
+    worker.searching = false;
+}
+
+/// Carries on the worker's search, then starts on its queue, until budget
+/// cells were expanded
+void solve( Worker & worker, grid::Info gridInfo,
+            const grid::Bitmap & gridData, int budget ) {
+    worker.finished.clear();
+    worker.results.clear();
+    worker.points.clear();
+
+    while ( true ) {
+        if ( !worker.searching ) {
+            if ( budget <= 0 || worker.queueIndex == worker.queue.size() ) {
+                break;
+            }
+
+            worker.query = worker.queue[ worker.queueIndex++ ];
+            const Query & query = worker.query;
+
+            if ( !grid::contains( gridInfo, query.start ) ||
+                 !grid::contains( gridInfo, query.end ) ) {
+                worker.finished.push_back( query );
+                worker.results.push_back( Result{ worker.points.size(), 0 } );
+                continue;
+            }
+
+            astar::startSearch( worker.context, gridInfo, query.start,
+                                query.end, query.mode, worker.search );
+            worker.searching = true;
+        }
+
+        // the iteration that reaches iterationMax gives up before expanding
+        astar::Search & search = worker.search;
+        int left = worker.query.iterationMax - 1 - search.iterations;
+        int iterations = search.iterations;
+
+        bool done = astar::continueSearch( worker.context, search, gridInfo,
+                                           gridData, std::min( budget, left ) );
+        budget -= search.iterations - iterations;
+
+        if ( !done && search.iterations < worker.query.iterationMax - 1 ) {
+            break;
+        }
+
+        finish( worker, gridData, gridInfo );
+    }
+}
+
+/// Whether b asks for the same search as a, so a's progress still counts
+bool sameSearch( const Query & a, const Query & b ) {
+    return a.id == b.id && a.start.x == b.start.x && a.start.y == b.start.y &&
+           a.end.x == b.end.x && a.end.y == b.end.y && a.mode == b.mode;
+}
+
+void join( Service & service ) {
+    for ( std::thread & thread : service.threads ) {
+        thread.join();
+    }
+    service.threads.clear();
+}
+
+} // namespace
+
+Service::~Service() {
+    join( *this );
+}
+
+void submit( Service & service, unsigned version, grid::Info gridInfo,
+             const grid::Bitmap & gridData,
+             std::vector< Query > & queries ) {
+    LOGGER_ASSERT( !service.busy );
+    join( service );
+
+    service.busy = true;
+
+    // the workers read the copy, so the grid can change under them
+    if ( service.version != version ||
+         service.gridInfo.width != gridInfo.width ||
+         service.gridInfo.height != gridInfo.height ) {
+        service.version = version;
+        service.gridInfo = gridInfo;
+        service.gridData = gridData;
+
+        // costs found on the old grid are no good, search again
+        std::vector< Query > restarted;
+        for ( Worker & worker : service.workers ) {
+            if ( worker.searching ) {
+                restarted.push_back( worker.query );
+                worker.searching = false;
+            }
+        }
+        service.waiting.insert( service.waiting.begin(), restarted.begin(),
+                                restarted.end() );
+    }
+
+    // newer queries replace unfinished ones for the same caller, unless
+    // they ask for the same search again, then the unfinished one carries on
+    if ( !queries.empty() ) {
+        std::unordered_map< long, Query > latest;
+        for ( const Query & query : queries ) {
+            latest[ query.id ] = query;
+        }
+
+        std::unordered_set< long > kept;
+        auto replaced = [ & ]( const Query & query ) {
+            auto it = latest.find( query.id );
+            if ( it == latest.end() ) {
+                return false;
+            }
+            if ( sameSearch( query, it->second ) ) {
+                kept.insert( query.id );
+                return false;
+            }
+            return true;
+        };
+
+        std::erase_if( service.waiting, replaced );
+        for ( Worker & worker : service.workers ) {
+            if ( worker.searching && replaced( worker.query ) ) {
+                worker.searching = false;
+            }
+        }
+
+        for ( const Query & query : queries ) {
+            auto it = latest.find( query.id );
+            if ( it != latest.end() && kept.count( query.id ) == 0 &&
+                 sameSearch( query, it->second ) ) {
+                service.waiting.push_back( query );
+                latest.erase( it );
+            }
+        }
+        queries.clear();
+    }
+
+    size_t searching = 0;
+    for ( const Worker & worker : service.workers ) {
+        searching += worker.searching;
+    }
+
+    size_t count = workerCount( service.waiting.size() + searching );
+    if ( service.workers.size() < count ) {
+        service.workers.resize( count );
+    }
+
+    // deal the queue out, a worker keeps the search it has in progress
+    for ( size_t i = 0; i < service.waiting.size(); i++ ) {
+        service.workers[ i % count ].queue.push_back( service.waiting[ i ] );
+    }
+    service.waiting.clear();
+
+    std::vector< Worker * > busyWorkers;
+    for ( Worker & worker : service.workers ) {
+        if ( worker.searching || !worker.queue.empty() ) {
+            busyWorkers.push_back( &worker );
+        } else {
+            worker.finished.clear();
+            worker.results.clear();
+            worker.points.clear();
+        }
+    }
+
+    if ( busyWorkers.empty() ) {
+        return;
+    }
+
+    int budget = std::max< int >( service.tickBudget / busyWorkers.size(), 1 );
+    for ( Worker * worker : busyWorkers ) {
+        service.threads.emplace_back( solve, std::ref( *worker ),
+                                      service.gridInfo,
+                                      std::cref( service.gridData ), budget );
+    }
+}
+
+bool collect( Service & service, Batch & outBatch ) {
+    join( service );
+
+    outBatch.queries.clear();
+    outBatch.results.clear();
+    outBatch.points.clear();
+
+    if ( !service.busy ) {
+        return false;
+    }
+
+    outBatch.gridInfo = service.gridInfo;
+
+    // pack the worker arenas, queries not started wait for the next tick
+    for ( Worker & worker : service.workers ) {
+        for ( size_t i = 0; i < worker.finished.size(); i++ ) {
+            Result result = worker.results[ i ];
+            auto first = worker.points.begin() + result.offset;
+
+            outBatch.queries.push_back( worker.finished[ i ] );
+            outBatch.results.push_back(
+                Result{ outBatch.points.size(), result.count } );
+            outBatch.points.insert( outBatch.points.end(), first,
+                                    first + result.count );
+        }
+
+        service.waiting.insert( service.waiting.end(),
+                                worker.queue.begin() + worker.queueIndex,
+                                worker.queue.end() );
+        worker.queue.clear();
+        worker.queueIndex = 0;
+    }
+
+    service.busy = false;
+
+    return true;
+}
+
+/// A search longer than one tick's budget, asked for again every tick the
+/// way waiting customers do, still finishes
+static void testRepeatedLongSearch() {
+    grid::Info info{ 64, 48 };
+    grid::Bitmap data;
+    grid::resize( data, info );
+
+    for ( int y = 0; y < 40; y++ ) {
+        grid::set( data, 20, y, true );
+        grid::set( data, 40, info.height - 1 - y, true );
+    }
+
+    Query query;
+    query.id = 7;
+    query.start = grid::Coord{ 2, 2 };
+    query.end = grid::Coord{ 60, 2 };
+    query.iterationMax = 100000;
+    query.mode = astar::kSearchAstar;
+
+    Service service;
+    service.tickBudget = 32;
+
+    Batch batch;
+    std::vector< Query > queries;
+    int ticks = 0;
+    while ( batch.results.empty() && ticks < 10000 ) {
+        queries.push_back( query );
+        submit( service, 1, info, data, queries );
+        collect( service, batch );
+        ticks++;
+    }
+
+    LOGGER_ASSERT( ticks > 1 );
+    LOGGER_ASSERT( batch.results.size() == 1 );
+    LOGGER_ASSERT( batch.results[ 0 ].count > 0 );
+
+    grid::Coord last = batch.points[ batch.results[ 0 ].count - 1 ];
+    LOGGER_ASSERT( last.x == query.end.x && last.y == query.end.y );
+}
+
+void runTests() {
+    testRepeatedLongSearch();
+}
+
+} // namespace pathQuery
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "Grid.h"
+#include "GridAstar.h"
+
+#include <thread>
+#include <vector>
+
+namespace pathQuery {
+
+struct Query {
+    // the caller's id for whoever asked, handed back with the result
+    long id;
+
+    grid::Coord start;
+    grid::Coord end;
+
+    // cells the search may expand over every tick it runs for
+    int iterationMax;
+    astar::SearchMode mode;
+};
+
+/// Span of a query's path in Batch::points, count is 0 when there is no path
+struct Result {
+    size_t offset;
+    size_t count;
+};
+
+/// Queries finished in one tick, results line up with the queries and their
+/// smoothed points are packed into one arena
+struct Batch {
+    grid::Info gridInfo;
+
+    std::vector< Query > queries;
+    std::vector< Result > results;
+    std::vector< grid::Coord > points;
+};
+
+struct Worker {
+    astar::SearchContext context;
+    astar::Path path;
+
+    // the search in progress keeps its state in context across ticks
+    Query query;
+    astar::Search search;
+    bool searching = false;
+
+    // queries dealt to the worker this tick
+    std::vector< Query > queue;
+    size_t queueIndex = 0;
+
+    // finished this tick
+    std::vector< Query > finished;
+    std::vector< Result > results;
+    std::vector< grid::Coord > points;
+};
+
+/// Solves queries on worker threads while the caller keeps ticking. Each tick
+/// the workers share a budget of expanded cells, a search that runs out of it
+/// carries on the next tick from where it stopped.
+///
+/// NOTE: collect before the game module is unloaded, the threads run code
+/// from it
+struct Service {
+    // cells expanded per tick over all workers
+    int tickBudget = 4096;
+
+    // snapshot the searches run against
+    unsigned version = 0;
+    grid::Info gridInfo{ 0, 0 };
+    grid::Bitmap gridData;
+
+    // submitted queries no worker has started on
+    std::vector< Query > waiting;
+
+    std::vector< Worker > workers;
+    std::vector< std::thread > threads;
+
+    bool busy = false;
+
+    ~Service();
+};
+
+/// Queues queries and spends this tick's budget on the queue. Searches begun
+/// on another grid version start over, and a query replaces any unfinished
+/// one with the same id, unless it asks for the same search, which then keeps
+/// its progress. The previous tick must have been collected. Takes the
+/// contents of queries.
+void submit( Service & service, unsigned version, grid::Info gridInfo,
+             const grid::Bitmap & gridData,
+             std::vector< Query > & queries );
+
+/// Waits for the workers and swaps the queries they finished into outBatch.
+/// Returns false (and empties outBatch) if nothing was submitted.
+bool collect( Service & service, Batch & outBatch );
+
+void runTests();
+
+} // namespace pathQuery
@@ -0,0 +1,53 @@
+#include "PathStore.h"
+
+#include "Logging.h"
+
+#include <limits>
+
+namespace pathStore {
+
+Handle add( Store & store, const grid::Coord * points, size_t count ) {
+    Handle handle;
+    handle.offset = store.points.size();
+    handle.count = count;
+
+    for ( size_t i = 0; i < count; i++ ) {
+        LOGGER_ASSERT( points[ i ].x <= std::numeric_limits< int16_t >::max() );
+        LOGGER_ASSERT( points[ i ].y <= std::numeric_limits< int16_t >::max() );
+
+        Point p;
+        p.x = points[ i ].x;
+        p.y = points[ i ].y;
+        store.points.push_back( p );
+    }
+
+    return handle;
+}
+
+void release( Store & store, Handle & handle ) {
+    store.releasedCount += handle.count;
+    handle = Handle{ 0, 0 };
+}
+
+grid::Coord point( const Store & store, Handle handle, size_t i ) {
+    Point p = store.points[ handle.offset + i ];
+    return grid::Coord{ p.x, p.y };
+}
+
+void compact( Store & store, std::span< Handle > handles ) {
+    if ( store.releasedCount * 2 < store.points.size() ) {
+        return;
+    }
+
+    store.spare.clear();
+    for ( Handle & handle : handles ) {
+        auto first = store.points.begin() + handle.offset;
+        handle.offset = store.spare.size();
+        store.spare.insert( store.spare.end(), first, first + handle.count );
+    }
+
+    store.points.swap( store.spare );
+    store.releasedCount = 0;
+}
+
+} // namespace pathStore
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace pathStore {
+
+/// Grid coordinate packed for storage, grids are well under 32k cells wide
+struct Point {
+    int16_t x;
+    int16_t y;
+};
+
+/// Span of a path in the store, an empty handle is no path
+struct Handle {
+    uint32_t offset;
+    uint32_t count;
+};
+
+/// Shared buffer for many paths. Released paths leave holes until the next
+/// compact.
+struct Store {
+    std::vector< Point > points;
+    size_t releasedCount = 0;
+
+    // compaction scratch, swapped with points
+    std::vector< Point > spare;
+};
+
+/// Appends a path and returns its handle
+Handle add( Store & store, const grid::Coord * points, size_t count );
+
+/// Frees the path's points and empties the handle
+void release( Store & store, Handle & handle );
+
+grid::Coord point( const Store & store, Handle handle, size_t i );
+
+/// Packs live paths together once released points outnumber them. handles
+/// has to hold every live handle, they are updated in place.
+void compact( Store & store, std::span< Handle > handles );
+
+} // namespace pathStore
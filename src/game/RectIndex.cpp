@@ -0,0 +1,147 @@
+#include "RectIndex.h"
+
+#include "Logging.h"
+
+#include <algorithm>
+
+namespace rectIndex {
+
+namespace {
+
+int floorDiv( int a, int b ) {
+    return a >= 0 ? a / b : ( a - b + 1 ) / b;
+}
+
+uint64_t bucketKey( int bx, int by ) {
+    return ( uint64_t( uint32_t( bx ) ) << 32 ) | uint32_t( by );
+}
+
+bool overlaps( Rect a, Rect b ) {
+    return a.x < b.x + b.w && b.x < a.x + a.w && a.y < b.y + b.h &&
+           b.y < a.y + a.h;
+}
+
+/// Bucket range [ x0, x1 ] x [ y0, y1 ] covered by rect, false if it's empty
+bool bucketRange( const Index & index, Rect rect, int * outRange ) {
+    if ( rect.w <= 0 || rect.h <= 0 ) {
+        return false;
+    }
+
+    outRange[ 0 ] = floorDiv( rect.x, index.bucketSize );
+    outRange[ 1 ] = floorDiv( rect.y, index.bucketSize );
+    outRange[ 2 ] = floorDiv( rect.x + rect.w - 1, index.bucketSize );
+    outRange[ 3 ] = floorDiv( rect.y + rect.h - 1, index.bucketSize );
+    return true;
+}
+
+} // namespace
+
+void insert( Index & index, int id, Rect rect ) {
+    if ( id >= std::ssize( index.rects ) ) {
+        index.rects.resize( id + 1, Rect{ 0, 0, 0, 0 } );
+        index.stamps.resize( id + 1, 0 );
+    }
+
+    LOGGER_ASSERT( index.rects[ id ].w <= 0 || index.rects[ id ].h <= 0 );
+    index.rects[ id ] = rect;
+
+    int range[ 4 ];
+    if ( !bucketRange( index, rect, range ) ) {
+        return;
+    }
+
+    for ( int by = range[ 1 ]; by <= range[ 3 ]; by++ ) {
+        for ( int bx = range[ 0 ]; bx <= range[ 2 ]; bx++ ) {
+            index.buckets[ bucketKey( bx, by ) ].push_back( id );
+        }
+    }
+}
+
+void remove( Index & index, int id ) {
+    int range[ 4 ];
+    if ( bucketRange( index, index.rects[ id ], range ) ) {
+        for ( int by = range[ 1 ]; by <= range[ 3 ]; by++ ) {
+            for ( int bx = range[ 0 ]; bx <= range[ 2 ]; bx++ ) {
+                auto it = index.buckets.find( bucketKey( bx, by ) );
+                std::vector< int > & ids = it->second;
+
+                ids.erase( std::find( ids.begin(), ids.end(), id ) );
+                if ( ids.empty() ) {
+                    index.buckets.erase( it );
+                }
+            }
+        }
+    }
+
+    index.rects[ id ] = Rect{ 0, 0, 0, 0 };
+}
+
+void query( Index & index, Rect rect, std::vector< int > & outIds ) {
+    outIds.clear();
+
+    int range[ 4 ];
+    if ( !bucketRange( index, rect, range ) ) {
+        return;
+    }
+
+    index.stamp++;
+
+    // stamps wrapped around, old stamps could alias the new query
+    if ( index.stamp == 0 ) {
+        std::fill( index.stamps.begin(), index.stamps.end(), 0 );
+        index.stamp = 1;
+    }
+
+    for ( int by = range[ 1 ]; by <= range[ 3 ]; by++ ) {
+        for ( int bx = range[ 0 ]; bx <= range[ 2 ]; bx++ ) {
+            auto it = index.buckets.find( bucketKey( bx, by ) );
+            if ( it == index.buckets.end() ) {
+                continue;
+            }
+
+            for ( int id : it->second ) {
+                if ( index.stamps[ id ] == index.stamp ) {
+                    continue;
+                }
+                index.stamps[ id ] = index.stamp;
+
+                if ( overlaps( index.rects[ id ], rect ) ) {
+                    outIds.push_back( id );
+                }
+            }
+        }
+    }
+}
+
+bool any( const Index & index, Rect rect ) {
+    int range[ 4 ];
+    if ( !bucketRange( index, rect, range ) ) {
+        return false;
+    }
+
+    for ( int by = range[ 1 ]; by <= range[ 3 ]; by++ ) {
+        for ( int bx = range[ 0 ]; bx <= range[ 2 ]; bx++ ) {
+            auto it = index.buckets.find( bucketKey( bx, by ) );
+            if ( it == index.buckets.end() ) {
+                continue;
+            }
+
+            for ( int id : it->second ) {
+                if ( overlaps( index.rects[ id ], rect ) ) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+void clear( Index & index ) {
+    index.buckets.clear();
+    index.rects.clear();
+    index.stamps.clear();
+    index.stamp = 0;
+}
+
+} // namespace rectIndex
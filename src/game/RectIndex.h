@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Rect.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace rectIndex {
+
+/// Broadphase over rects in unbounded square buckets. Each bucket lists the
+/// ids of the rects overlapping it, so a query only looks at the rects near
+/// the queried area.
+struct Index {
+    int bucketSize = 32;
+
+    std::unordered_map< uint64_t, std::vector< int > > buckets;
+
+    // indexed by id, rects the index doesn't hold have a zero size
+    std::vector< Rect > rects;
+
+    // query stamps, so a rect spanning several buckets is reported once
+    std::vector< unsigned > stamps;
+    unsigned stamp = 0;
+};
+
+/// id must not be in the index already
+void insert( Index & index, int id, Rect rect );
+
+void remove( Index & index, int id );
+
+/// Replaces outIds with the ids of every rect overlapping rect, in no
+/// particular order
+void query( Index & index, Rect rect, std::vector< int > & outIds );
+
+/// Whether any rect overlaps rect
+bool any( const Index & index, Rect rect );
+
+void clear( Index & index );
+
+} // namespace rectIndex
@@ -0,0 +1,166 @@
+#include "Registry.h"
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <functional>
+#include <random>
+
+namespace registry {
+
+namespace {
+
+uint32_t slotOf( Id id ) {
+    return (uint32_t) ( id & 0xffffffff );
+}
+
+Id makeId( uint32_t slot, uint32_t generation ) {
+    return (Id) ( ( (uint64_t) generation << 32 ) | slot );
+}
+
+} // namespace
+
+Id create( Registry & registry ) {
+    uint32_t slot;
+    if ( !registry.freeSlots.empty() ) {
+        slot = registry.freeSlots.back();
+        registry.freeSlots.pop_back();
+    } else {
+        slot = registry.sparse.size();
+        registry.sparse.push_back( -1 );
+        registry.generations.push_back( 0 );
+    }
+
+    Id id = makeId( slot, registry.generations[ slot ] );
+    registry.sparse[ slot ] = registry.dense.size();
+    registry.dense.push_back( id );
+
+    return id;
+}
+
+int find( const Registry & registry, Id id ) {
+    uint32_t slot = slotOf( id );
+    if ( id < 0 || slot >= registry.sparse.size() ||
+         makeId( slot, registry.generations[ slot ] ) != id ) {
+        return -1;
+    }
+
+    return registry.sparse[ slot ];
+}
+
+void removeAt( Registry & registry, int index ) {
+    LOGGER_ASSERT( index >= 0 && index < (int) registry.dense.size() );
+
+    uint32_t slot = slotOf( registry.dense[ index ] );
+    Id last = registry.dense.back();
+
+    registry.dense[ index ] = last;
+    registry.sparse[ slotOf( last ) ] = index;
+    registry.dense.pop_back();
+
+    // bumping the generation retires every copy of the old id
+    registry.sparse[ slot ] = -1;
+    registry.generations[ slot ]++;
+    registry.freeSlots.push_back( slot );
+}
+
+void removeMany( Registry & registry, const Id * ids, size_t count,
+                 std::vector< int > & outIndices ) {
+    outIndices.clear();
+    for ( size_t i = 0; i < count; i++ ) {
+        int index = find( registry, ids[ i ] );
+        if ( index >= 0 ) {
+            outIndices.push_back( index );
+        }
+    }
+
+    // from the back the entity moved into a hole is never one still to go
+    std::sort( outIndices.begin(), outIndices.end(), std::greater< int >() );
+    outIndices.erase( std::unique( outIndices.begin(), outIndices.end() ),
+                      outIndices.end() );
+
+    for ( int index : outIndices ) {
+        removeAt( registry, index );
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+/// A removed id stays gone after its slot is reused
+void testGenerations() {
+    Registry registry;
+
+    Id a = create( registry );
+    Id b = create( registry );
+    LOGGER_ASSERT( find( registry, a ) == 0 && find( registry, b ) == 1 );
+
+    removeAt( registry, find( registry, a ) );
+    LOGGER_ASSERT( find( registry, a ) == -1 );
+    LOGGER_ASSERT( find( registry, b ) == 0 );
+
+    Id c = create( registry );
+    LOGGER_ASSERT( slotOf( c ) == slotOf( a ) && c != a );
+    LOGGER_ASSERT( find( registry, a ) == -1 );
+    LOGGER_ASSERT( find( registry, c ) == 1 );
+
+    LOGGER_ASSERT( find( registry, -1 ) == -1 );
+    LOGGER_ASSERT( find( registry, makeId( 5, 0 ) ) == -1 );
+}
+
+/// Random batches of removals, with repeats and ids already gone, keep a
+/// column swap removed in outIndices order lined up with dense
+void testRemoveMany() {
+    std::mt19937 rng( 2 );
+    Registry registry;
+
+    // what the caller keeps in its columns
+    std::vector< Id > column;
+    std::vector< Id > retired;
+    std::vector< Id > ids;
+    std::vector< int > removed;
+
+    for ( int round = 0; round < 200; round++ ) {
+        int creates = rng() % 20;
+        for ( int i = 0; i < creates; i++ ) {
+            column.push_back( create( registry ) );
+        }
+
+        ids.clear();
+        int removes = rng() % 16;
+        for ( int i = 0; i < removes && !column.empty(); i++ ) {
+            ids.push_back( column[ rng() % column.size() ] );
+        }
+        if ( !retired.empty() ) {
+            ids.push_back( retired[ rng() % retired.size() ] );
+        }
+
+        size_t before = column.size();
+        removeMany( registry, ids.data(), ids.size(), removed );
+
+        for ( int index : removed ) {
+            retired.push_back( column[ index ] );
+            column[ index ] = column.back();
+            column.pop_back();
+        }
+
+        LOGGER_ASSERT( column.size() + removed.size() == before );
+        LOGGER_ASSERT( column == registry.dense );
+        for ( size_t i = 0; i < column.size(); i++ ) {
+            LOGGER_ASSERT( find( registry, column[ i ] ) == (int) i );
+        }
+        for ( Id id : ids ) {
+            LOGGER_ASSERT( find( registry, id ) == -1 );
+        }
+    }
+}
+
+} // namespace
+
+void runTests() {
+    testGenerations();
+    testRemoveMany();
+}
+
+} // namespace registry
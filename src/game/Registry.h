@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace registry {
+
+/// Slot in the low 32 bits and the slot's generation above them, so the id of
+/// a removed entity never finds whoever gets the slot next
+using Id = long;
+
+/// Sparse set from ids to indices into columns that are kept packed. Removing
+/// moves the last entity into the hole, the caller swap removes every column
+/// at the same index to keep them lined up with dense.
+struct Registry {
+    // by slot, index into dense or -1 while the slot is free
+    std::vector< int > sparse;
+    std::vector< uint32_t > generations;
+    std::vector< uint32_t > freeSlots;
+
+    // ids in column order
+    std::vector< Id > dense;
+};
+
+/// Adds an entity after the last one and returns its id
+Id create( Registry & registry );
+
+/// Index of id in the columns, -1 if it was removed or never created
+int find( const Registry & registry, Id id );
+
+/// Removes the entity at index, the last one takes its place
+void removeAt( Registry & registry, int index );
+
+/// Removes the ids that are still around, repeats count once. outIndices gets
+/// the indices in the order they were removed, from the back, so swap
+/// removing the columns in that order matches the registry.
+void removeMany( Registry & registry, const Id * ids, size_t count,
+                 std::vector< int > & outIndices );
+
+void runTests();
+
+} // namespace registry
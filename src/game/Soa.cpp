@@ -0,0 +1,82 @@
+#include "Soa.h"
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace soa {
+
+namespace {
+
+struct Row {
+    uint8_t tag;
+    std::string name;
+    double value;
+};
+
+using TestTable = Table< uint8_t, std::string, double >;
+
+bool sameRows( const TestTable & table, const std::vector< Row > & rows ) {
+    if ( size( table ) != rows.size() ) {
+        return false;
+    }
+
+    std::span< const uint8_t > tag = column< 0 >( table );
+    std::span< const std::string > name = column< 1 >( table );
+    std::span< const double > value = column< 2 >( table );
+
+    for ( size_t i = 0; i < rows.size(); i++ ) {
+        if ( tag[ i ] != rows[ i ].tag || name[ i ] != rows[ i ].name ||
+             value[ i ] != rows[ i ].value ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/// Random pushes and swap removes, through growing the block a few times,
+/// keep every column lined up with rows kept one struct each
+void testSwapRemove() {
+    std::mt19937 rng( 4 );
+    TestTable table;
+    std::vector< Row > rows;
+
+    for ( int op = 0; op < 2000; op++ ) {
+        if ( rows.empty() || rng() % 3 != 0 ) {
+            // long enough that the strings own heap memory
+            Row row{ uint8_t( rng() ),
+                     "row " + std::to_string( op ) + std::string( 20, 'x' ),
+                     rng() * 0.5 };
+            size_t index = push( table, row.tag, row.name, row.value );
+            LOGGER_ASSERT( index == rows.size() );
+            rows.push_back( row );
+        } else {
+            size_t index = rng() % rows.size();
+            swapRemove( table, index );
+            rows[ index ] = rows.back();
+            rows.pop_back();
+        }
+
+        LOGGER_ASSERT( sameRows( table, rows ) );
+    }
+
+    LOGGER_ASSERT( table.capacity >= size( table ) );
+
+    clear( table );
+    rows.clear();
+    LOGGER_ASSERT( sameRows( table, rows ) );
+
+    push( table, uint8_t( 1 ), std::string( "again" ), 2.0 );
+    rows.push_back( Row{ 1, "again", 2.0 } );
+    LOGGER_ASSERT( sameRows( table, rows ) );
+}
+
+} // namespace
+
+void runTests() {
+    testSwapRemove();
+}
+
+} // namespace soa
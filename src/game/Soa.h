@@ -0,0 +1,175 @@
+#pragma once
+
+#include "Logging.h"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace soa {
+
+/// Rows of parallel columns, one column per type, kept in a single block. All
+/// columns share one capacity, so adding a row is one capacity check and
+/// growing moves every column into a new block at once. Columns are named by
+/// their index, see column.
+template < typename... Columns > struct Table {
+    static constexpr size_t kColumnCount = sizeof...( Columns );
+
+    // the block is aligned for the most aligned column
+    static constexpr size_t kAlign =
+        std::max( { alignof( std::max_align_t ), alignof( Columns )... } );
+
+    // columns one after the other in the block, each aligned for its type
+    unsigned char * block = nullptr;
+    std::array< size_t, kColumnCount > offsets{};
+
+    size_t count = 0;
+    size_t capacity = 0;
+
+    Table() = default;
+    Table( const Table & ) = delete;
+    Table & operator=( const Table & ) = delete;
+    ~Table();
+};
+
+template < size_t I, typename... Columns >
+using ColumnType = std::tuple_element_t< I, std::tuple< Columns... > >;
+
+namespace detail {
+
+/// Calls f( std::integral_constant< size_t, I >{} ) for every column index
+template < typename... Columns, typename F >
+void forEachColumn( F && f ) {
+    [ & ]< size_t... I >( std::index_sequence< I... > ) {
+        ( f( std::integral_constant< size_t, I >{} ), ... );
+    }( std::index_sequence_for< Columns... >{} );
+}
+
+template < size_t I, typename... Columns >
+ColumnType< I, Columns... > * data( const Table< Columns... > & table ) {
+    using T = ColumnType< I, Columns... >;
+    return std::launder( (T *) ( table.block + table.offsets[ I ] ) );
+}
+
+} // namespace detail
+
+template < typename... Columns >
+size_t size( const Table< Columns... > & table ) {
+    return table.count;
+}
+
+/// Makes room for capacity rows without moving them again
+template < typename... Columns >
+void reserve( Table< Columns... > & table, size_t capacity ) {
+    using TableType = Table< Columns... >;
+    if ( capacity <= table.capacity ) {
+        return;
+    }
+
+    std::array< size_t, TableType::kColumnCount > offsets;
+    size_t blockSize = 0;
+    detail::forEachColumn< Columns... >( [ & ]( auto i ) {
+        using T = ColumnType< i, Columns... >;
+        blockSize = ( blockSize + alignof( T ) - 1 ) / alignof( T ) *
+                    alignof( T );
+        offsets[ i ] = blockSize;
+        blockSize += capacity * sizeof( T );
+    } );
+
+    unsigned char * block = (unsigned char *) ::operator new(
+        blockSize, std::align_val_t( TableType::kAlign ) );
+
+    detail::forEachColumn< Columns... >( [ & ]( auto i ) {
+        using T = ColumnType< i, Columns... >;
+        T * from = detail::data< i >( table );
+        T * to = (T *) ( block + offsets[ i ] );
+        std::uninitialized_move_n( from, table.count, to );
+        std::destroy_n( from, table.count );
+    } );
+
+    if ( table.block ) {
+        ::operator delete( table.block,
+                           std::align_val_t( TableType::kAlign ) );
+    }
+
+    table.block = block;
+    table.offsets = offsets;
+    table.capacity = capacity;
+}
+
+/// Appends a row and returns its index
+template < typename... Columns >
+size_t push( Table< Columns... > & table,
+             std::type_identity_t< Columns >... row ) {
+    if ( table.count == table.capacity ) {
+        reserve( table, std::max< size_t >( table.capacity * 2, 16 ) );
+    }
+
+    std::tuple< Columns &... > values{ row... };
+    detail::forEachColumn< Columns... >( [ & ]( auto i ) {
+        using T = ColumnType< i, Columns... >;
+        T * column = detail::data< i >( table );
+        new ( column + table.count ) T( std::move( std::get< i >( values ) ) );
+    } );
+
+    return table.count++;
+}
+
+/// Removes the row at index, the last row takes its place
+template < typename... Columns >
+void swapRemove( Table< Columns... > & table, size_t index ) {
+    LOGGER_ASSERT( index < table.count );
+
+    size_t last = table.count - 1;
+    detail::forEachColumn< Columns... >( [ & ]( auto i ) {
+        auto * column = detail::data< i >( table );
+        if ( index != last ) {
+            column[ index ] = std::move( column[ last ] );
+        }
+        std::destroy_at( column + last );
+    } );
+
+    table.count = last;
+}
+
+/// Removes every row, keeping the block
+template < typename... Columns > void clear( Table< Columns... > & table ) {
+    detail::forEachColumn< Columns... >( [ & ]( auto i ) {
+        std::destroy_n( detail::data< i >( table ), table.count );
+    } );
+    table.count = 0;
+}
+
+/// Column I over the rows, valid until the table grows
+template < size_t I, typename... Columns >
+std::span< ColumnType< I, Columns... > > column( Table< Columns... > & table ) {
+    return { detail::data< I >( table ), table.count };
+}
+
+template < size_t I, typename... Columns >
+std::span< const ColumnType< I, Columns... > >
+column( const Table< Columns... > & table ) {
+    return { detail::data< I >( table ), table.count };
+}
+
+template < size_t I, typename... Columns >
+ColumnType< I, Columns... > & at( Table< Columns... > & table, size_t index ) {
+    return detail::data< I >( table )[ index ];
+}
+
+template < typename... Columns > Table< Columns... >::~Table() {
+    if ( block ) {
+        clear( *this );
+        ::operator delete( block, std::align_val_t( kAlign ) );
+    }
+}
+
+void runTests();
+
+} // namespace soa
@@ -0,0 +1,44 @@
+#include "SpatialHash.h"
+
+#include "Logging.h"
+
+namespace spatialHash {
+
+void build( Hash & hash, grid::Info bounds, float cellSize,
+            const glm::vec2 * points, size_t count ) {
+    LOGGER_ASSERT( cellSize > 0.0f );
+
+    hash.cellSize = cellSize;
+    hash.width = std::max( (int) std::ceil( bounds.width / cellSize ), 1 );
+    hash.height = std::max( (int) std::ceil( bounds.height / cellSize ), 1 );
+
+    size_t cellCount = (size_t) hash.width * hash.height;
+
+    // count the points of each bucket one past it, the prefix sum then turns
+    // the counts into starts
+    hash.cellStarts.assign( cellCount + 1, 0 );
+    hash.pointCells.resize( count );
+    for ( size_t i = 0; i < count; i++ ) {
+        int x = cellCoord( hash, points[ i ].x, hash.width );
+        int y = cellCoord( hash, points[ i ].y, hash.height );
+        uint32_t cell = y * hash.width + x;
+
+        hash.pointCells[ i ] = cell;
+        hash.cellStarts[ cell + 1 ]++;
+    }
+
+    for ( size_t cell = 0; cell < cellCount; cell++ ) {
+        hash.cellStarts[ cell + 1 ] += hash.cellStarts[ cell ];
+    }
+
+    hash.cursors.assign( hash.cellStarts.begin(), hash.cellStarts.end() - 1 );
+    hash.ids.resize( count );
+    hash.points.resize( count );
+    for ( size_t i = 0; i < count; i++ ) {
+        uint32_t slot = hash.cursors[ hash.pointCells[ i ] ]++;
+        hash.ids[ slot ] = i;
+        hash.points[ slot ] = points[ i ];
+    }
+}
+
+} // namespace spatialHash
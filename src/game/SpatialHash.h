@@ -0,0 +1,74 @@
+#pragma once
+
+#include "Grid.h"
+
+#include <glm/vec2.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace spatialHash {
+
+/// Uniform buckets over points, rebuilt from scratch whenever they move. The
+/// buckets tile the world's grid and points past its edges go to the edge
+/// buckets. Points are counting sorted by bucket, so a bucket's points are
+/// one span of ids and points.
+struct Hash {
+    float cellSize = 1.0f;
+
+    // in buckets
+    int width = 0;
+    int height = 0;
+
+    // bucket i holds ids and points [ cellStarts[ i ], cellStarts[ i + 1 ] )
+    std::vector< uint32_t > cellStarts;
+    std::vector< uint32_t > ids;
+    std::vector< glm::vec2 > points;
+
+    // build scratch, bucket of each point and the next free slot of each
+    std::vector< uint32_t > pointCells;
+    std::vector< uint32_t > cursors;
+};
+
+/// Buckets points[ 0, count ) over a world of bounds, ids are indices into
+/// points. Points in a bucket keep their order.
+void build( Hash & hash, grid::Info bounds, float cellSize,
+            const glm::vec2 * points, size_t count );
+
+/// Bucket column or row of a coordinate, clamped to the buckets
+inline int cellCoord( const Hash & hash, float v, int size ) {
+    int c = (int) std::floor( v / hash.cellSize );
+    return std::clamp( c, 0, size - 1 );
+}
+
+/// Calls visit( id, point ) for the points in every bucket that overlaps the
+/// square of radius around p, row by row. Stops early once visit returns
+/// false.
+template < typename Visit >
+void query( const Hash & hash, glm::vec2 p, float radius, Visit && visit ) {
+    if ( hash.ids.empty() ) {
+        return;
+    }
+
+    int x0 = cellCoord( hash, p.x - radius, hash.width );
+    int y0 = cellCoord( hash, p.y - radius, hash.height );
+    int x1 = cellCoord( hash, p.x + radius, hash.width );
+    int y1 = cellCoord( hash, p.y + radius, hash.height );
+
+    // the buckets of a row are next to each other, so are their points
+    for ( int y = y0; y <= y1; y++ ) {
+        size_t row = (size_t) y * hash.width;
+        uint32_t first = hash.cellStarts[ row + x0 ];
+        uint32_t last = hash.cellStarts[ row + x1 + 1 ];
+
+        for ( uint32_t i = first; i < last; i++ ) {
+            if ( !visit( hash.ids[ i ], hash.points[ i ] ) ) {
+                return;
+            }
+        }
+    }
+}
+
+} // namespace spatialHash
@@ -1,22 +1,38 @@
 #include "Tycoon.h"
 
+#include "FlowFields.h"
+#include "FrameArena.h"
 #include "Graphics.h"
 #include "GridAstar.h"
+#include "GridDstar.h"
+#include "Hpa.h"
 #include "Logging.h"
 #include "Math.h"
+#include "PathCache.h"
 #include "PathGrid.h"
+#include "PathQuery.h"
+#include "PathStore.h"
 #include "Physics.h"
 #include "ResourceDirectory.h"
 #include "ShaderProgram.h"
+#include "SpatialHash.h"
 #include "Texture.h"
+#include "WorkerPool.h"
 
 #include <glm/gtx/norm.hpp>
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <bit>
 #include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <limits>
 
+#if defined( __SSE2__ )
+#include <xmmintrin.h>
+#endif
+
 namespace tycoon {
 
 static void tryReloadModule( state::GameState & state );
@@ -60,6 +76,13 @@ static const std::vector< std::string > kToolNames = { "table", "wall", "human",
 //     state::KitchenType{ { 1, 2, 3 } },
 // };
 
+// cluster size of the hierarchical path graph, in collision grid cells
+static const int kPathClusterSize = 16;
+
+// cells one customer path search may expand, spread over as many ticks as the
+// path query budget takes
+static const int kPathIterationMax = 2000;
+
 static const state::Recipes kRecipes{
     .durations = { 1, 2, 3, 4 },
     .prices = { 5, 15, 25, 30 },
@@ -222,31 +245,13 @@ static LineAndArrow lineAndArrowTransform( int x1, int x2, int y1, int y2,
 
 ////////////////////////////////////////////////////////////////////////////////
 
-template < typename T >
-static bool vectorFind( const std::vector< T > & v, const T & t,
-                        int * index = nullptr ) {
-    for ( int i = 0; i < std::ssize( v ); i++ ) {
-        if ( v[ i ] == t ) {
-            if ( index ) {
-                *index = i;
-            }
-            return true;
-        }
-    }
-
-    return false;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-
 template < typename T >
 void vectorRemoveByIndex( std::vector< T > & v, state::index_t index ) {
     if ( index == v.size() - 1 ) {
         v.pop_back();
     } else {
-        T t = v.back();
+        v[ index ] = std::move( v.back() );
         v.pop_back();
-        v[ index ] = t;
     }
 }
 
@@ -265,16 +270,41 @@ static glm::vec2 screenToView( state::GameState & state, float x, float y ) {
 
 ////////////////////////////////////////////////////////////////////////////////
 
-static bool collidesWithWalls( state::GameState & state, const Rect & rect ) {
+/// The cell under the mouse
+static Rect cursorRect( state::GameState & state ) {
+    Rect rect;
+    rect.x = state.tycoon.mousePosition.x;
+    rect.y = state.tycoon.mousePosition.y;
+    rect.w = 1;
+    rect.h = 1;
+    return rect;
+}
 
-    for ( auto & wall : state.tycoon.walls ) {
-        phys::CollisionInfo info;
-        if ( phys::collideAABB( rect, wall, info ) ) {
-            return true;
-        }
+static void addWall( state::GameState & state, Rect wall ) {
+    std::vector< Rect > & walls = state.tycoon.walls;
+
+    rectIndex::insert( state.tycoon.wallIndex, walls.size(), wall );
+    walls.push_back( wall );
+}
+
+/// Swaps the last wall into the hole, so its index changes to i
+static void removeWall( state::GameState & state, int i ) {
+    std::vector< Rect > & walls = state.tycoon.walls;
+    rectIndex::Index & index = state.tycoon.wallIndex;
+
+    int last = walls.size() - 1;
+
+    rectIndex::remove( index, i );
+    if ( i != last ) {
+        rectIndex::remove( index, last );
+        rectIndex::insert( index, i, walls[ last ] );
     }
 
-    return false;
+    vectorRemoveByIndex( walls, i );
+}
+
+static bool collidesWithWalls( state::GameState & state, const Rect & rect ) {
+    return rectIndex::any( state.tycoon.wallIndex, rect );
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -327,124 +357,231 @@ static void tickTimers( std::vector< float > & ioTimers, float timestep ) {
     }
 }
 
-#define GET_TABLE_COLUMN( table, out, fieldName )                              \
-    for ( size_t i = 0; i < table.size(); i++ ) {                              \
-        out[ i ] = table[ i ].fieldName;                                       \
-    }
+/// Stamps the cells of wall that fall inside clip into the collision grid
+static void rasterizeWall( grid::Bitmap & grid, Rect wall, Rect clip ) {
+    wall = math::marginRect( wall, -1 );
 
-#define SET_TABLE_COLUMN( table, in, fieldName )                               \
-    for ( size_t i = 0; i < table.size(); i++ ) {                              \
-        table[ i ].fieldName = in[ i ];                                        \
-    }
+    int x0 = std::max( wall.x, clip.x );
+    int y0 = std::max( wall.y, clip.y );
+    int x1 = std::min( wall.x + wall.w, clip.x + clip.w );
+    int y1 = std::min( wall.y + wall.h, clip.y + clip.h );
 
-#define DEFINE_COLUMN( name, table, fieldName )                                \
-    std::vector< decltype( table[ 0 ].fieldName ) > name( table.size() )
+    for ( int y = y0; y < y1; y++ ) {
+        for ( int x = x0; x < x1; x++ ) {
+            grid::set( grid, x, y, true );
+        }
+    }
+}
 
+/// Rasterizes every wall into a fresh grid when the grid changes size, and
+/// rebuilds everything that depends on it
 static void computeCollisionGrid( state::GameState & state ) {
-    // build collision grid
     grid::Info & gridInfo = state.tycoon.collisionGridInfo;
-    std::vector< int > & grid = state.tycoon.collisionGridData;
-    std::vector< int > & pathGridCosts = state.tycoon.pathGridCosts;
-    std::vector< unsigned char > & pathGridField = state.tycoon.pathGridField;
+    grid::Bitmap & grid = state.tycoon.collisionGridData;
+
+    // wall edits keep a grid of the same size current
+    if ( !grid.tiles.empty() &&
+         gridInfo.width == state.rendering.subRenderWidth &&
+         gridInfo.height == state.rendering.subRenderHeight ) {
+        return;
+    }
 
     gridInfo.width = state.rendering.subRenderWidth;
     gridInfo.height = state.rendering.subRenderHeight;
 
-    size_t gridSize = gridInfo.width * gridInfo.height;
+    // invalidates cached paths
+    state.tycoon.collisionGridVersion++;
 
-    int defaultCost = std::numeric_limits< int >::max();
-
-    grid = std::vector< int >( gridSize, 0 );
-    pathGridCosts = std::vector< int >( gridSize, defaultCost );
-    pathGridField = std::vector< unsigned char >( gridSize, 0 );
+    grid::resize( grid, gridInfo );
 
+    Rect bounds{ 0, 0, gridInfo.width, gridInfo.height };
     for ( Rect wall : state.tycoon.walls ) {
-        wall = math::marginRect( wall, -1 );
-
-        for ( int i = 0; i < wall.w; i++ ) {
-            for ( int j = 0; j < wall.h; j++ ) {
-                int x = wall.x + i;
-                int y = wall.y + j;
-
-                if ( grid::contains( gridInfo, x, y ) ) {
-                    auto index = grid::index( gridInfo, x, y );
-                    grid[ index ] = 1;
-                }
-            }
-        }
+        rasterizeWall( grid, wall, bounds );
     }
 
-    grid::Coord pathGridTarget;
-    pathGridTarget.x = gridInfo.width / 2;
-    pathGridTarget.y = gridInfo.height / 2;
-
-    size_t targetIndex = grid::index( gridInfo, pathGridTarget );
-    pathGridCosts[ targetIndex ] = 0;
+    hpa::build( state.tycoon.collisionGraph, gridInfo, grid,
+                kPathClusterSize );
+    flowFields::clear( state.tycoon.flowFields );
+    state.tycoon.waypointPlanner.initialized = false;
 }
 
-static void iteratePathGrids( state::GameState & state ) {
-    pathGrid::Info info;
-    info.gridInfo = state.tycoon.collisionGridInfo;
-    info.mask = &state.tycoon.collisionGridData;
-    info.costs = &state.tycoon.pathGridCosts;
-    info.field = &state.tycoon.pathGridField;
+/// Re-rasterizes the walls over region after walls were added or removed
+/// there, and repairs the path structures for only the cells that changed
+static void updateCollisionRegion( state::GameState & state, Rect region ) {
+    grid::Info gridInfo = state.tycoon.collisionGridInfo;
+    grid::Bitmap & grid = state.tycoon.collisionGridData;
+
+    // walls block one cell past their rect
+    region = math::marginRect( region, -1 );
+
+    Rect clip;
+    clip.x = std::max( region.x, 0 );
+    clip.y = std::max( region.y, 0 );
+    clip.w = std::min( region.x + region.w, gridInfo.width ) - clip.x;
+    clip.h = std::min( region.y + region.h, gridInfo.height ) - clip.y;
+    if ( clip.w <= 0 || clip.h <= 0 ) {
+        return;
+    }
 
-    grid::Info gridInfo = info.gridInfo;
+    // region cells in row order
+    std::vector< bool > wasBlocked( clip.w * clip.h );
 
-    grid::Coord pathGridTarget;
-    pathGridTarget.x = gridInfo.width / 2;
-    pathGridTarget.y = gridInfo.height / 2;
+    for ( int y = clip.y; y < clip.y + clip.h; y++ ) {
+        for ( int x = clip.x; x < clip.x + clip.w; x++ ) {
+            size_t i = ( y - clip.y ) * clip.w + x - clip.x;
+            wasBlocked[ i ] = grid::test( grid, x, y );
+            grid::set( grid, x, y, false );
+        }
+    }
 
-    size_t targetIndex = grid::index( gridInfo, pathGridTarget );
+    // walls reaching into the region, with the cell they block past their rect
+    std::vector< int > hits;
+    rectIndex::query( state.tycoon.wallIndex, math::marginRect( clip, -1 ),
+                      hits );
+    for ( int i : hits ) {
+        rasterizeWall( grid, state.tycoon.walls[ i ], clip );
+    }
 
-    static int startI = 0;
-    startI = ( startI + 1 ) % 2;
+    hpa::Graph & graph = state.tycoon.collisionGraph;
+    dstar::Planner & planner = state.tycoon.waypointPlanner;
+    std::vector< size_t > changedCells;
 
-    for ( size_t i = startI; i < grid::size( info.gridInfo ); i += 2 ) {
+    for ( int y = clip.y; y < clip.y + clip.h; y++ ) {
+        for ( int x = clip.x; x < clip.x + clip.w; x++ ) {
+            size_t i = ( y - clip.y ) * clip.w + x - clip.x;
+            if ( grid::test( grid, x, y ) == wasBlocked[ i ] ) {
+                continue;
+            }
 
-        if ( i == targetIndex )
-            continue;
+            hpa::markDirty( graph, x, y );
+            if ( planner.initialized ) {
+                dstar::updateCell( planner, grid, grid::Coord{ x, y } );
+            }
+            changedCells.push_back( grid::index( gridInfo, x, y ) );
+        }
+    }
 
-        grid::Coord coord = grid::coord( info.gridInfo, i );
+    if ( changedCells.empty() ) {
+        return;
+    }
 
-        // coord.x = rand() % info.gridInfo.width;
-        // coord.y = rand() % info.gridInfo.height;
+    // invalidates cached paths
+    state.tycoon.collisionGridVersion++;
 
-        pathGrid::iterate( info, coord );
+    hpa::refresh( graph, grid );
+    flowFields::update( state.tycoon.flowFields, gridInfo, grid,
+                        changedCells );
+}
+
+/// Reuses a cached path for the human, or queues a path query for it and the
+/// path is filled in once it lands, the human is awaiting it until then
+static void requestPathForHuman( state::GameState & state,
+                                 state::index_t index, glm::vec2 target ) {
+    state::TycoonSim & sim = state.tycoon.tycoonSim;
+    auto & customers = sim.customers.columns;
+    grid::Info gridInfo = state.tycoon.collisionGridInfo;
+
+    glm::vec2 pos = soa::at< state::kCustomerPosition >( customers, index );
+
+    pathQuery::Query query;
+    query.id = soa::at< state::kCustomerId >( customers, index );
+    query.start.x = pos.x;
+    query.start.y = pos.y;
+    query.end.x = target.x;
+    query.end.y = target.y;
+    query.iterationMax = kPathIterationMax;
+    query.mode = astar::kSearchJumpPoint;
+
+    if ( grid::contains( gridInfo, query.start ) &&
+         grid::contains( gridInfo, query.end ) ) {
+        pathCache::Cache & cache = sim.pathCache;
+        pathCache::sync( cache, state.tycoon.collisionGridVersion );
+
+        std::vector< grid::Coord > & points = sim.pathScratch;
+        if ( pathCache::find( cache, sim.searchContext, gridInfo,
+                              state.tycoon.collisionGridData, query.start,
+                              query.end, points ) ) {
+            pathStore::Handle & path =
+                soa::at< state::kCustomerPath >( customers, index );
+            pathStore::release( sim.customerPaths, path );
+            path = pathStore::add( sim.customerPaths, points.data(),
+                                   points.size() );
+            soa::at< state::kCustomerPathIndex >( customers, index ) = 0;
+            return;
+        }
     }
+
+    sim.queuedPathQueries.push_back( query );
+    soa::at< state::kCustomerAwaitingPath >( customers, index ) = 1;
 }
 
-static astar::Path * computePathForHuman( state::GameState & state,
-                                          glm::vec2 pos, glm::vec2 target ) {
+/// Hands this tick's queued path queries to the workers, they pick up the
+/// searches still running from earlier ticks too
+static void submitPathQueries( state::GameState & state ) {
+    state::TycoonSim & sim = state.tycoon.tycoonSim;
 
-    grid::Info & gridInfo = state.tycoon.collisionGridInfo;
-    std::vector< int > & grid = state.tycoon.collisionGridData;
+    sim.pendingPathVersion = state.tycoon.collisionGridVersion;
 
-    grid::Coord start;
-    grid::Coord end;
+    pathQuery::submit( sim.pathQueries, state.tycoon.collisionGridVersion,
+                       state.tycoon.collisionGridInfo,
+                       state.tycoon.collisionGridData, sim.queuedPathQueries );
+}
 
-    start.x = pos.x;
-    start.y = pos.y;
-    end.x = target.x;
-    end.y = target.y;
+/// Copies the paths finished last tick to the humans that are still around
+static void applyPathResults( state::GameState & state ) {
+    state::TycoonSim & sim = state.tycoon.tycoonSim;
+    pathQuery::Batch & batch = sim.pathResults;
 
-    if ( !grid::contains( gridInfo, start.x, start.y ) ) {
-        return nullptr;
+    if ( !pathQuery::collect( sim.pathQueries, batch ) ) {
+        return;
     }
 
-    if ( !grid::contains( gridInfo, end.x, end.y ) ) {
-        return nullptr;
+    // paths from an older grid still get used, just not cached
+    unsigned version = state.tycoon.collisionGridVersion;
+    bool cacheable = sim.pendingPathVersion == version;
+    if ( cacheable ) {
+        pathCache::sync( sim.pathCache, sim.pendingPathVersion );
     }
 
-    auto pathPtr = new astar::Path();
-    *pathPtr = astar::shortestPath( gridInfo, grid, start, end, 100 );
+    for ( size_t i = 0; i < batch.results.size(); i++ ) {
+        pathQuery::Result result = batch.results[ i ];
+        auto first = batch.points.begin() + result.offset;
+
+        grid::Coord end = batch.queries[ i ].end;
+        bool complete = result.count > 0 &&
+                        first[ result.count - 1 ].x == end.x &&
+                        first[ result.count - 1 ].y == end.y;
+        if ( cacheable && complete ) {
+            pathCache::insert( sim.pathCache, batch.gridInfo, &first[ 0 ],
+                               result.count );
+        }
 
-    return pathPtr;
+        state::index_t index =
+            registry::find( sim.customers.registry, batch.queries[ i ].id );
+        if ( index < 0 ) {
+            continue;
+        }
+
+        auto & customers = sim.customers.columns;
+        pathStore::Handle & path =
+            soa::at< state::kCustomerPath >( customers, index );
+        pathStore::release( sim.customerPaths, path );
+        path = pathStore::add( sim.customerPaths, &first[ 0 ], result.count );
+        soa::at< state::kCustomerPathIndex >( customers, index ) = 0;
+        soa::at< state::kCustomerAwaitingPath >( customers, index ) = 0;
+    }
 }
 
-static state::id_t genId() {
-    static state::id_t count = 0;
-    return count++;
+/// Plans a coarse route over the cluster graph, legs of it are refined into
+/// paths only as the human reaches them
+static void computeRouteForHuman( state::GameState & state, glm::vec2 pos,
+                                  glm::vec2 target,
+                                  std::vector< grid::Coord > & outRoute ) {
+    grid::Coord start{ (int) pos.x, (int) pos.y };
+    grid::Coord end{ (int) target.x, (int) target.y };
+
+    hpa::findRoute( state.tycoon.collisionGraph,
+                    state.tycoon.collisionGridData, start, end, outRoute );
 }
 
 static void addHuman( state::GameState & state, glm::vec2 pos ) {
@@ -453,41 +590,39 @@ static void addHuman( state::GameState & state, glm::vec2 pos ) {
     glm::vec2 target{ state.rendering.subRenderWidth * 0.5f,
                       state.rendering.subRenderHeight * 0.5f };
 
-    sim.customers.position.push_back( pos );
-    sim.customers.velocity.push_back( glm::vec2{ 0, 0 } );
-    sim.customers.subtarget.push_back( pos );
-    sim.customers.target.push_back( target );
-    sim.customers.path.push_back( nullptr );
-    sim.customers.pathIndex.push_back( 0 );
-    sim.customers.repathTimer.push_back( 0.0f );
-    sim.customers.id.push_back( genId() );
+    // reused slots differ in their generation, mix it into the seed
+    state::id_t id = registry::create( sim.customers.registry );
+    uint32_t seed = (uint32_t) ( id ^ ( id >> 32 ) );
+
+    soa::push( sim.customers.columns, id, pos, glm::vec2{ 0, 0 }, target, pos,
+               0.0f, seed * 2654435761u | 1, pathStore::Handle{ 0, 0 }, 0, 0,
+               std::vector< grid::Coord >{}, 0, -1, -1, 0 );
 }
 
-static void removeHuman( state::GameState & state, state::id_t id ) {
+/// Removes the humans with the given ids, ones already gone are skipped
+static void removeHumans( state::GameState & state,
+                          const std::vector< state::id_t > & ids ) {
     state::TycoonSim & sim = state.tycoon.tycoonSim;
+    std::vector< state::index_t > & removed = sim.removedCustomers;
 
-    state::index_t index;
-    if ( !vectorFind( sim.customers.id, id, &index ) ) {
-        LOGGER_ASSERT( false );
-    }
+    auto & customers = sim.customers.columns;
 
-    // DEBUG_LOG() << "Removing human " << id << " from index " << index
-    //             << std::endl;
+    registry::removeMany( sim.customers.registry, ids.data(), ids.size(),
+                          removed );
+    for ( state::index_t index : removed ) {
+        pathStore::Handle & path =
+            soa::at< state::kCustomerPath >( customers, index );
+        pathStore::release( sim.customerPaths, path );
+        soa::swapRemove( customers, index );
+    }
 
-    vectorRemoveByIndex( sim.customers.position, index );
-    vectorRemoveByIndex( sim.customers.velocity, index );
-    vectorRemoveByIndex( sim.customers.subtarget, index );
-    vectorRemoveByIndex( sim.customers.target, index );
-    vectorRemoveByIndex( sim.customers.path, index );
-    vectorRemoveByIndex( sim.customers.pathIndex, index );
-    vectorRemoveByIndex( sim.customers.repathTimer, index );
-    vectorRemoveByIndex( sim.customers.id, index );
+    LOGGER_ASSERT( soa::size( customers ) ==
+                   sim.customers.registry.dense.size() );
 }
 
 static bool validCollisionCell( state::GameState & state, grid::Coord coord ) {
     if ( grid::contains( state.tycoon.collisionGridInfo, coord ) ) {
-        auto index = grid::index( state.tycoon.collisionGridInfo, coord );
-        if ( state.tycoon.collisionGridData[ index ] == 0 ) {
+        if ( !grid::test( state.tycoon.collisionGridData, coord ) ) {
             return true;
         }
     }
@@ -502,18 +637,48 @@ static void tickPathables( state::GameState & state ) {
     const float step = 20.0f * state.tickTimestep;
     const float deltaTime = state.tickTimestep;
 
-    std::vector< glm::vec2 > & pos = sim.customers.position;
-    std::vector< glm::vec2 > & vel = sim.customers.velocity;
-    std::vector< glm::vec2 > & subtarget = sim.customers.subtarget;
-    std::vector< glm::vec2 > & target = sim.customers.target;
-    std::vector< astar::Path * > & path = sim.customers.path;
-    std::vector< index_t > & pathIndex = sim.customers.pathIndex;
-    std::vector< float > & repathTimer = sim.customers.repathTimer;
+    auto & customers = sim.customers.columns;
+
+    std::span< glm::vec2 > pos =
+        soa::column< state::kCustomerPosition >( customers );
+    std::span< glm::vec2 > vel =
+        soa::column< state::kCustomerVelocity >( customers );
+    std::span< glm::vec2 > subtarget =
+        soa::column< state::kCustomerSubtarget >( customers );
+    std::span< glm::vec2 > target =
+        soa::column< state::kCustomerTarget >( customers );
+    std::span< pathStore::Handle > path =
+        soa::column< state::kCustomerPath >( customers );
+    pathStore::Store & paths = sim.customerPaths;
+    std::span< index_t > pathIndex =
+        soa::column< state::kCustomerPathIndex >( customers );
+    std::span< uint8_t > awaitingPath =
+        soa::column< state::kCustomerAwaitingPath >( customers );
+    std::span< std::vector< grid::Coord > > route =
+        soa::column< state::kCustomerRoute >( customers );
+    std::span< index_t > routeIndex =
+        soa::column< state::kCustomerRouteIndex >( customers );
+    std::span< float > repathTimer =
+        soa::column< state::kCustomerRepathTimer >( customers );
     std::vector< state::id_t > & stoppedAtTargetId = sim.customersAtTarget;
-    std::vector< state::id_t > & id = sim.customers.id;
+    std::span< state::id_t > id =
+        soa::column< state::kCustomerId >( customers );
+
+    applyPathResults( state );
+
+    // every selection below holds at most one entry per human
+    frameArena::Arena & arena = sim.scratch;
+    frameArena::reset( arena );
+    size_t count = pos.size();
+
+    auto indices = [ & ]() {
+        return frameArena::makeList< index_t >( arena, count );
+    };
 
-    std::vector< glm::vec2 > dir;
-    std::vector< float > len;
+    frameArena::List< glm::vec2 > dir =
+        frameArena::makeList< glm::vec2 >( arena, count );
+    frameArena::List< float > len =
+        frameArena::makeList< float >( arena, count );
 
     ////////////////////////////////////////////////////////////////////////////
     // compute dir and len
@@ -524,8 +689,8 @@ static void tickPathables( state::GameState & state ) {
         len.push_back( glm::length( localDir ) );
     }
 
-    std::vector< index_t > running;
-    std::vector< index_t > stopped;
+    frameArena::List< index_t > running = indices();
+    frameArena::List< index_t > stopped = indices();
 
     ////////////////////////////////////////////////////////////////////////////
     // split up into running and stopped humans
@@ -538,8 +703,8 @@ static void tickPathables( state::GameState & state ) {
         }
     }
 
-    std::vector< index_t > stoppedAtSubtarget;
-    std::vector< index_t > stoppedAtTarget;
+    frameArena::List< index_t > stoppedAtSubtarget = indices();
+    frameArena::List< index_t > stoppedAtTarget = indices();
 
     ////////////////////////////////////////////////////////////////////////////
     // split up into humans stopped at final targets and just subtargets
@@ -566,18 +731,21 @@ static void tickPathables( state::GameState & state ) {
         pos[ index ] = subtarget[ index ];
     }
 
-    std::vector< index_t > hasNextTarget;
-    std::vector< index_t > noNextTarget;
-    std::vector< index_t > noPath;
+    frameArena::List< index_t > hasNextTarget = indices();
+    frameArena::List< index_t > noNextTarget = indices();
+    frameArena::List< index_t > noPath = indices();
 
     ////////////////////////////////////////////////////////////////////////////
-    // split up by whether they have a next target
+    // split up by whether they have a next target, humans without a path
+    // that already asked for one just wait for it
     ////////////////////////////////////////////////////////////////////////////
     for ( index_t index : stoppedAtSubtarget ) {
-        astar::Path * localPath = path[ index ];
-        if ( !localPath ) {
-            noPath.push_back( index );
-        } else if ( pathIndex[ index ] + 1 < localPath->points.size() ) {
+        pathStore::Handle localPath = path[ index ];
+        if ( localPath.count == 0 ) {
+            if ( !awaitingPath[ index ] ) {
+                noPath.push_back( index );
+            }
+        } else if ( pathIndex[ index ] + 1 < (index_t) localPath.count ) {
             hasNextTarget.push_back( index );
         } else {
             noNextTarget.push_back( index );
@@ -596,7 +764,8 @@ static void tickPathables( state::GameState & state ) {
     ////////////////////////////////////////////////////////////////////////////
     for ( index_t index : hasNextTarget ) {
         index_t localPathIndex = pathIndex[ index ];
-        grid::Coord nextSubtarget = path[ index ]->points[ localPathIndex ];
+        grid::Coord nextSubtarget =
+            pathStore::point( paths, path[ index ], localPathIndex );
 
         int rx = rand() % 5 - 2;
         int ry = rand() % 5 - 2;
@@ -614,7 +783,49 @@ static void tickPathables( state::GameState & state ) {
         }
     }
 
-    std::vector< index_t > canRepath;
+    ////////////////////////////////////////////////////////////////////////////
+    // advance the route of humans that finished their leg
+    ////////////////////////////////////////////////////////////////////////////
+    for ( index_t index : noNextTarget ) {
+        if ( routeIndex[ index ] < std::ssize( route[ index ] ) ) {
+            grid::Coord waypoint = route[ index ][ routeIndex[ index ] ];
+            pathStore::Handle localPath = path[ index ];
+            grid::Coord reached =
+                pathStore::point( paths, localPath, localPath.count - 1 );
+
+            if ( reached.x == waypoint.x && reached.y == waypoint.y ) {
+                routeIndex[ index ]++;
+            }
+        }
+    }
+
+    frameArena::List< index_t > hasNextLeg = indices();
+    frameArena::List< index_t > noNextLeg = indices();
+
+    ////////////////////////////////////////////////////////////////////////////
+    // split up by whether their route has legs left, the next leg of humans
+    // awaiting its path is already asked for
+    ////////////////////////////////////////////////////////////////////////////
+    for ( index_t index : noNextTarget ) {
+        if ( routeIndex[ index ] < std::ssize( route[ index ] ) ) {
+            if ( !awaitingPath[ index ] ) {
+                hasNextLeg.push_back( index );
+            }
+        } else {
+            noNextLeg.push_back( index );
+        }
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // refine the next leg of the route
+    ////////////////////////////////////////////////////////////////////////////
+    for ( index_t index : hasNextLeg ) {
+        grid::Coord waypoint = route[ index ][ routeIndex[ index ] ];
+        requestPathForHuman( state, index,
+                             glm::vec2{ waypoint.x, waypoint.y } );
+    }
+
+    frameArena::List< index_t > canRepath = indices();
 
     ////////////////////////////////////////////////////////////////////////////
     // select humans that can repath
@@ -622,7 +833,7 @@ static void tickPathables( state::GameState & state ) {
     for ( index_t index : running ) {
         canRepath.push_back( index );
     }
-    for ( index_t index : noNextTarget ) {
+    for ( index_t index : noNextLeg ) {
         canRepath.push_back( index );
     }
 
@@ -633,7 +844,7 @@ static void tickPathables( state::GameState & state ) {
         repathTimer[ index ] -= deltaTime;
     }
 
-    std::vector< index_t > needRepath;
+    frameArena::List< index_t > needRepath = indices();
 
     ////////////////////////////////////////////////////////////////////////////
     // select humans that need repathing
@@ -647,37 +858,44 @@ static void tickPathables( state::GameState & state ) {
         needRepath.push_back( index );
     }
 
-    std::vector< index_t > stalePaths;
+    frameArena::List< index_t > stalePaths = indices();
 
     ////////////////////////////////////////////////////////////////////////////
     // select humans with stale paths
     ////////////////////////////////////////////////////////////////////////////
     for ( index_t index : stoppedAtTarget ) {
-        if ( path[ index ] ) {
-            stalePaths.push_back( index );
-        }
-    }
-    for ( index_t index : needRepath ) {
-        if ( path[ index ] ) {
+        if ( path[ index ].count > 0 ) {
             stalePaths.push_back( index );
         }
     }
 
     ////////////////////////////////////////////////////////////////////////////
-    // delete finished paths
+    // release finished paths
     ////////////////////////////////////////////////////////////////////////////
     for ( index_t index : stalePaths ) {
-        delete path[ index ];
-        path[ index ] = nullptr;
+        pathStore::release( paths, path[ index ] );
     }
 
     ////////////////////////////////////////////////////////////////////////////
-    // repath humans to their targets
+    // replan routes of humans that need repathing
     ////////////////////////////////////////////////////////////////////////////
     for ( index_t index : needRepath ) {
-        path[ index ] =
-            computePathForHuman( state, pos[ index ], target[ index ] );
-        pathIndex[ index ] = 0;
+        computeRouteForHuman( state, pos[ index ], target[ index ],
+                              route[ index ] );
+        routeIndex[ index ] = 0;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // repath humans to their first waypoint (or target without a route)
+    ////////////////////////////////////////////////////////////////////////////
+    for ( index_t index : needRepath ) {
+        glm::vec2 legTarget = target[ index ];
+        if ( !route[ index ].empty() ) {
+            grid::Coord waypoint = route[ index ][ 0 ];
+            legTarget = glm::vec2{ waypoint.x, waypoint.y };
+        }
+
+        requestPathForHuman( state, index, legTarget );
     }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -693,6 +911,10 @@ static void tickPathables( state::GameState & state ) {
     for ( index_t index : stoppedAtTarget ) {
         stoppedAtTargetId.push_back( id[ index ] );
     }
+
+    submitPathQueries( state );
+
+    pathStore::compact( paths, path );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -701,166 +923,550 @@ static void tickHumanAi( state::GameState & state ) {
     //
 }
 
-static void tickMassPathables( state::GameState & state ) {
-    using index_t = int;
+/// Directions for each pathGrid::Vector, bits are +x, -x, +y, -y. Opposing
+/// bits resolve toward +x or +y.
+static const glm::vec2 kFieldDirections[ 16 ] = {
+    glm::vec2{ 1, 0 },         // 0000
+    glm::vec2{ 0, -1 },        // 0001
+    glm::vec2{ 0, 1 },         // 0010
+    glm::vec2{ 0, 1 },         // 0011
+    glm::vec2{ -1, 0 },        // 0100
+    glm::vec2{ -0.7f, -0.7f }, // 0101
+    glm::vec2{ -0.7f, 0.7f },  // 0110
+    glm::vec2{ 0, 1 },         // 0111
+    glm::vec2{ 1, 0 },         // 1000
+    glm::vec2{ 0.7f, -0.7f },  // 1001
+    glm::vec2{ 0.7f, 0.7f },   // 1010
+    glm::vec2{ 0, 1 },         // 1011
+    glm::vec2{ 1, 0 },         // 1100
+    glm::vec2{ 1, 0 },         // 1101
+    glm::vec2{ 1, 0 },         // 1110
+    glm::vec2{ 1, 0 },         // 1111
+};
 
-    state::TycoonSim & sim = state.tycoon.tycoonSim;
+/// Movement jitter, a quarter turn apart
+static const glm::vec2 kJitterDirections[ 4 ] = {
+    glm::vec2{ 0.5f, 0.0f },
+    glm::vec2{ 0.0f, 0.5f },
+    glm::vec2{ -0.5f, 0.0f },
+    glm::vec2{ 0.0f, -0.5f },
+};
+
+// humans are steered and moved in chunks of this many, a multiple of the SIMD
+// width, so the chunks split the same way whatever the thread count
+static const size_t kMoveChunkSize = 1024;
+
+// fewer humans than this aren't worth handing to the worker pool
+static const size_t kParallelHumansMin = 8192;
+
+// fieldIndex of humans off the grid, and their goal cell
+static const uint32_t kNoField = std::numeric_limits< uint32_t >::max();
+
+// humans closer than this push each other apart, in collision grid cells.
+// Also the bucket size of the customer hash.
+static const float kSeparationRadius = 2.0f;
+
+// push at zero distance, against the field direction's 1
+static const float kSeparationWeight = 1.5f;
+
+// a human is pushed by at most this many of its nearest neighbors within
+// the radius, so a packed crowd pushes no harder than a loose one
+static const int kSeparationNeighborsMax = 8;
+
+/// Per human streams of tickMassPathables. A chunk of humans only touches its
+/// own entries, so chunks can run on any thread.
+struct MassStreams {
+    std::span< glm::vec2 > pos;
+    std::span< glm::vec2 > vel;
+    std::span< glm::vec2 > target;
+    std::span< uint32_t > rngState;
+
+    // into flowFields::Manager::fields, looked up before a human's goal
+    // group is steered
+    frameArena::List< uint32_t > fieldIndex;
+
+    // where the field and jitter push each human, x and y apart for moveHumans
+    frameArena::List< float > steerX;
+    frameArena::List< float > steerY;
+
+    frameArena::List< uint8_t > atTarget;
+
+    // away from the others nearby, added to the steering when separating
+    frameArena::List< float > pushX;
+    frameArena::List< float > pushY;
+};
+
+/// Field direction toward each target plus jitter, and whether the human is
+/// already there, for the humans order[ begin, end )
+static void steerHumans( const state::GameState & state,
+                         MassStreams & streams, const uint32_t * order,
+                         size_t begin, size_t end ) {
+    bool separate = state.tycoon.separateHumans;
+
+    const grid::Info & gridInfo = state.tycoon.collisionGridInfo;
+    const std::vector< flowFields::Field > & fields =
+        state.tycoon.flowFields.fields;
+
+    for ( size_t i = begin; i < end; i++ ) {
+        uint32_t index = order[ i ];
+        glm::vec2 pos = streams.pos[ index ];
+        glm::vec2 target = streams.target[ index ];
+        streams.atTarget[ index ] = glm::length( target - pos ) < 2.0f;
+
+        pathGrid::Vector vector = 0;
+
+        // zero when there's no slope, the 4-bit direction is used then
+        glm::vec2 gradient{ 0, 0 };
+
+        // the field was found for this human's group just before it steered
+        uint32_t fieldIndex = streams.fieldIndex[ index ];
+        if ( fieldIndex != kNoField ) {
+            const flowFields::Field & field = fields[ fieldIndex ];
+
+            grid::Coord coord{ (int) pos.x, (int) pos.y };
+            vector = field.field[ grid::index( gridInfo, coord ) ];
+
+            if ( state.tycoon.sampleFieldGradient ) {
+                pathGrid::sampleGradient( gridInfo, field.costs, pos.x, pos.y,
+                                          &gradient.x, &gradient.y );
+            }
+        }
+
+        bool hasGradient = gradient.x != 0.0f || gradient.y != 0.0f;
+        glm::vec2 out = hasGradient ? gradient : kFieldDirections[ vector ];
 
+        uint32_t jitter = math::xorshift32( streams.rngState[ index ] ) >> 30;
+        out += kJitterDirections[ jitter ];
+
+        if ( separate ) {
+            out += glm::vec2{ streams.pushX[ index ], streams.pushY[ index ] };
+        }
+
+        streams.steerX[ index ] = out.x;
+        streams.steerY[ index ] = out.y;
+    }
+}
+
+/// Push of each human away from its nearest others within kSeparationRadius,
+/// for the hash slots [ begin, end ). Going in bucket order keeps the
+/// neighbors of consecutive humans close in memory. Which neighbors count
+/// only depends on their distances, so the order of the buckets can't favor
+/// one side.
+static void separateHumans( const spatialHash::Hash & hash,
+                            MassStreams & streams, size_t begin, size_t end ) {
+    const float radius2 = kSeparationRadius * kSeparationRadius;
+
+    for ( size_t slot = begin; slot < end; slot++ ) {
+        uint32_t index = hash.ids[ slot ];
+        glm::vec2 pos = hash.points[ slot ];
+
+        // the nearest so far in no order, and the closest of the ones that
+        // didn't fit
+        float nearDistance2[ kSeparationNeighborsMax ];
+        glm::vec2 nearAway[ kSeparationNeighborsMax ];
+        int nearCount = 0;
+        int farthest = 0;
+        float droppedDistance2 = radius2;
+
+        auto visit = [ & ]( uint32_t other, glm::vec2 otherPos ) {
+            // humans on the same spot are split by their jitter instead
+            glm::vec2 away = pos - otherPos;
+            float distance2 = glm::dot( away, away );
+            if ( distance2 >= droppedDistance2 || distance2 <= 1e-8f ||
+                 other == index ) {
+                return true;
+            }
+
+            if ( nearCount < kSeparationNeighborsMax ) {
+                nearDistance2[ nearCount ] = distance2;
+                nearAway[ nearCount ] = away;
+                if ( distance2 > nearDistance2[ farthest ] ) {
+                    farthest = nearCount;
+                }
+                nearCount++;
+                return true;
+            }
+
+            if ( distance2 >= nearDistance2[ farthest ] ) {
+                droppedDistance2 = distance2;
+                return true;
+            }
+
+            droppedDistance2 = nearDistance2[ farthest ];
+            nearDistance2[ farthest ] = distance2;
+            nearAway[ farthest ] = away;
+            for ( int i = 0; i < kSeparationNeighborsMax; i++ ) {
+                if ( nearDistance2[ i ] > nearDistance2[ farthest ] ) {
+                    farthest = i;
+                }
+            }
+
+            return true;
+        };
+        spatialHash::query( hash, pos, kSeparationRadius, visit );
+
+        // falls off linearly to zero at the radius. Neighbors as far as one
+        // that didn't fit are left out too, which of them fit depends on
+        // the order they were found in.
+        glm::vec2 push{ 0, 0 };
+        for ( int i = 0; i < nearCount; i++ ) {
+            if ( nearDistance2[ i ] >= droppedDistance2 ) {
+                continue;
+            }
+
+            float distance = std::sqrt( nearDistance2[ i ] );
+            push += nearAway[ i ] *
+                    ( 1.0f / distance - 1.0f / kSeparationRadius );
+        }
+
+        streams.pushX[ index ] = push.x * kSeparationWeight;
+        streams.pushY[ index ] = push.y * kSeparationWeight;
+    }
+}
+
+/// Moves the human to newPos unless it's off the grid or in a wall
+static void tryMove( const state::GameState & state, glm::vec2 & pos,
+                     glm::vec2 newPos ) {
+    grid::Coord coord;
+    coord.x = newPos.x;
+    coord.y = newPos.y;
+
+    if ( grid::contains( state.tycoon.collisionGridInfo, coord ) &&
+         !grid::test( state.tycoon.collisionGridData, coord ) ) {
+        pos = newPos;
+    }
+}
+
+/// Accelerates humans along their steering, clamps their speed and steps them
+/// forward. Four at a time with SSE, begin has to be a multiple of four. The
+/// lanes do the same float operations in the same order as the scalar loop,
+/// so results don't depend on where a chunk ends.
+static void moveHumans( const state::GameState & state, MassStreams & streams,
+                        size_t begin, size_t end ) {
     const float step = 20.0f * state.tickTimestep;
     const float deltaTime = state.tickTimestep;
 
-    std::vector< glm::vec2 > & pos = sim.customers.position;
-    std::vector< glm::vec2 > & vel = sim.customers.velocity;
-    std::vector< glm::vec2 > & subtarget = sim.customers.subtarget;
-    std::vector< glm::vec2 > & target = sim.customers.target;
-    std::vector< astar::Path * > & path = sim.customers.path;
-    std::vector< index_t > & pathIndex = sim.customers.pathIndex;
-    std::vector< float > & repathTimer = sim.customers.repathTimer;
-    std::vector< state::id_t > & stoppedAtTargetId = sim.customersAtTarget;
-    std::vector< state::id_t > & id = sim.customers.id;
+    static_assert( sizeof( glm::vec2 ) == 2 * sizeof( float ) );
+
+    glm::vec2 * pos = streams.pos.data();
+    glm::vec2 * vel = streams.vel.data();
+    const float * steerX = streams.steerX.items;
+    const float * steerY = streams.steerY.items;
+
+    size_t index = begin;
+
+#if defined( __SSE2__ )
+    const __m128 accel = _mm_set1_ps( 1000.0f );
+    const __m128 dt = _mm_set1_ps( deltaTime );
+    const __m128 one = _mm_set1_ps( 1.0f );
+    const __m128 speedMax = _mm_set1_ps( 100.0f );
+    const __m128 epsilon = _mm_set1_ps( 1e-6f );
+    const __m128 stepLanes = _mm_set1_ps( step );
+
+    for ( ; index + 4 <= end; index += 4 ) {
+        // x and y lanes of four humans, the vec2 columns are de-interleaved
+        float * v = &vel[ index ].x;
+        __m128 v01 = _mm_loadu_ps( v );
+        __m128 v23 = _mm_loadu_ps( v + 4 );
+        __m128 vx = _mm_shuffle_ps( v01, v23, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+        __m128 vy = _mm_shuffle_ps( v01, v23, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+
+        __m128 sx = _mm_loadu_ps( steerX + index );
+        __m128 sy = _mm_loadu_ps( steerY + index );
+        vx = _mm_add_ps( vx, _mm_mul_ps( _mm_mul_ps( sx, accel ), dt ) );
+        vy = _mm_add_ps( vy, _mm_mul_ps( _mm_mul_ps( sy, accel ), dt ) );
+
+        // clamp speed to 100
+        __m128 len = _mm_sqrt_ps(
+            _mm_add_ps( _mm_mul_ps( vx, vx ), _mm_mul_ps( vy, vy ) ) );
+        __m128 scale = _mm_min_ps(
+            one, _mm_div_ps( speedMax, _mm_max_ps( len, epsilon ) ) );
+        vx = _mm_mul_ps( vx, scale );
+        vy = _mm_mul_ps( vy, scale );
+
+        _mm_storeu_ps( v, _mm_unpacklo_ps( vx, vy ) );
+        _mm_storeu_ps( v + 4, _mm_unpackhi_ps( vx, vy ) );
+
+        // a step along the velocity, the grid test is per human
+        len = _mm_sqrt_ps(
+            _mm_add_ps( _mm_mul_ps( vx, vx ), _mm_mul_ps( vy, vy ) ) );
+
+        float * p = &pos[ index ].x;
+        __m128 p01 = _mm_loadu_ps( p );
+        __m128 p23 = _mm_loadu_ps( p + 4 );
+        __m128 px = _mm_shuffle_ps( p01, p23, _MM_SHUFFLE( 2, 0, 2, 0 ) );
+        __m128 py = _mm_shuffle_ps( p01, p23, _MM_SHUFFLE( 3, 1, 3, 1 ) );
+
+        alignas( 16 ) float lens[ 4 ];
+        alignas( 16 ) float newX[ 4 ];
+        alignas( 16 ) float newY[ 4 ];
+        _mm_store_ps( lens, len );
+        __m128 dx = _mm_div_ps( _mm_mul_ps( vx, stepLanes ), len );
+        __m128 dy = _mm_div_ps( _mm_mul_ps( vy, stepLanes ), len );
+        _mm_store_ps( newX, _mm_add_ps( px, dx ) );
+        _mm_store_ps( newY, _mm_add_ps( py, dy ) );
+
+        for ( int lane = 0; lane < 4; lane++ ) {
+            if ( lens[ lane ] > 0 ) {
+                tryMove( state, pos[ index + lane ],
+                         glm::vec2{ newX[ lane ], newY[ lane ] } );
+            }
+        }
+    }
+#endif
 
-    std::vector< glm::vec2 > dir;
-    std::vector< float > len;
+    for ( ; index < end; index++ ) {
+        vel[ index ].x += steerX[ index ] * 1000.0f * deltaTime;
+        vel[ index ].y += steerY[ index ] * 1000.0f * deltaTime;
+        float len = glm::length( vel[ index ] );
 
-    ////////////////////////////////////////////////////////////////////////////
-    // compute dir and len to target
-    ////////////////////////////////////////////////////////////////////////////
-    for ( index_t index = 0; index < pos.size(); index++ ) {
-        glm::vec2 localDir = target[ index ] - pos[ index ];
-        dir.push_back( localDir );
-        len.push_back( glm::length( localDir ) );
-    }
+        // clamp speed to 100
+        vel[ index ] *= std::min( 1.0f, 100.0f / std::max( len, 1e-6f ) );
 
-    ////////////////////////////////////////////////////////////////////////////
-    // select humans at target
-    ////////////////////////////////////////////////////////////////////////////
-    for ( index_t index = 0; index < pos.size(); index++ ) {
-        if ( len[ index ] < 2.0f ) {
-            stoppedAtTargetId.push_back( id[ index ] );
+        len = glm::length( vel[ index ] );
+        if ( len > 0 ) {
+            glm::vec2 newPos = pos[ index ] + vel[ index ] * step / len;
+            tryMove( state, pos[ index ], newPos );
         }
     }
+}
 
-    std::vector< pathGrid::Vector > pathVector;
+/// Calls f( begin, end ) over [ 0, count ) in kMoveChunkSize pieces, spread
+/// over the worker pool once there are enough humans to pay for it
+template < typename F > static void forEachChunk( size_t count, F && f ) {
+    size_t chunkCount = ( count + kMoveChunkSize - 1 ) / kMoveChunkSize;
 
-    ////////////////////////////////////////////////////////////////////////////
-    // get field direction at spots
-    ////////////////////////////////////////////////////////////////////////////
-    for ( index_t index = 0; index < pos.size(); index++ ) {
-        grid::Coord coord;
-        coord.x = pos[ index ].x;
-        coord.y = pos[ index ].y;
+    auto chunk = [ & ]( int i ) {
+        size_t begin = i * kMoveChunkSize;
+        f( begin, std::min( begin + kMoveChunkSize, count ) );
+    };
 
-        grid::Info & gridInfo = state.tycoon.collisionGridInfo;
-        if ( grid::contains( gridInfo, coord ) ) {
-            size_t gridIndex = grid::index( gridInfo, coord );
-            pathVector.push_back( state.tycoon.pathGridField[ gridIndex ] );
-        } else {
-            pathVector.push_back( 0 );
+    if ( count < kParallelHumansMin ) {
+        for ( size_t i = 0; i < chunkCount; i++ ) {
+            chunk( i );
         }
+        return;
     }
 
-    std::vector< glm::vec2 > pathVel;
+    workerPool::run( (int) chunkCount, chunk );
+}
+
+static void tickMassPathables( state::GameState & state ) {
+    state::TycoonSim & sim = state.tycoon.tycoonSim;
+
+    auto & customers = sim.customers.columns;
+
+    std::span< glm::vec2 > target =
+        soa::column< state::kCustomerTarget >( customers );
+    std::vector< state::id_t > & stoppedAtTargetId = sim.customersAtTarget;
+    std::span< state::id_t > id =
+        soa::column< state::kCustomerId >( customers );
+
+    frameArena::Arena & arena = sim.scratch;
+    frameArena::reset( arena );
+    size_t count = soa::size( customers );
+
+    MassStreams streams;
+    streams.pos = soa::column< state::kCustomerPosition >( customers );
+    streams.vel = soa::column< state::kCustomerVelocity >( customers );
+    streams.target = target;
+    streams.rngState = soa::column< state::kCustomerRngState >( customers );
+    streams.fieldIndex = frameArena::makeList< uint32_t >( arena, count );
+    streams.steerX = frameArena::makeList< float >( arena, count );
+    streams.steerY = frameArena::makeList< float >( arena, count );
+    streams.atTarget = frameArena::makeList< uint8_t >( arena, count );
+    streams.pushX = frameArena::makeList< float >( arena, count );
+    streams.pushY = frameArena::makeList< float >( arena, count );
+    streams.steerX.resize( count );
+    streams.steerY.resize( count );
+    streams.atTarget.resize( count );
+    streams.pushX.resize( count );
+    streams.pushY.resize( count );
+
+    grid::Info & gridInfo = state.tycoon.collisionGridInfo;
+    flowFields::Manager & fields = state.tycoon.flowFields;
 
     ////////////////////////////////////////////////////////////////////////////
-    // turn field direction to vec2
+    // group humans by goal cell, group 0 is the humans with no field
     ////////////////////////////////////////////////////////////////////////////
-    for ( pathGrid::Vector v : pathVector ) {
-        glm::vec2 out = glm::vec2{ 1, 0 };
-        switch ( v ) {
-        case 0b1000:
-            out = glm::vec2{ 1, 0 };
-            break;
-        case 0b0100:
-            out = glm::vec2{ -1, 0 };
-            break;
-        case 0b0010:
-            out = glm::vec2{ 0, 1 };
-            break;
-        case 0b0001:
-            out = glm::vec2{ 0, -1 };
-            break;
 
-        case 0b1010:
-            out = glm::vec2{ 0.7f, 0.7f };
-            break;
-        case 0b1001:
-            out = glm::vec2{ 0.7f, -0.7f };
-            break;
-        case 0b0110:
-            out = glm::vec2{ -0.7f, 0.7f };
-            break;
-        case 0b0101:
-            out = glm::vec2{ -0.7f, -0.7f };
-            break;
+    // open addressing from goal cell to group, with room for every human
+    // having a goal of its own
+    size_t slotCount = std::bit_ceil( std::max< size_t >( 2 * count, 16 ) );
+    int slotShift = 32 - std::countr_zero( slotCount );
+    frameArena::List< uint32_t > slotGoals =
+        frameArena::makeList< uint32_t >( arena, slotCount );
+    frameArena::List< uint32_t > slotGroups =
+        frameArena::makeList< uint32_t >( arena, slotCount );
+    slotGoals.resize( slotCount );
+    slotGroups.resize( slotCount );
+    std::fill( slotGoals.begin(), slotGoals.end(), kNoField );
+
+    frameArena::List< uint32_t > groupGoals =
+        frameArena::makeList< uint32_t >( arena, count + 1 );
+    frameArena::List< uint32_t > groupStarts =
+        frameArena::makeList< uint32_t >( arena, count + 2 );
+    frameArena::List< uint32_t > humanGroups =
+        frameArena::makeList< uint32_t >( arena, count );
+    groupGoals.push_back( kNoField );
+    groupStarts.push_back( 0 );
+    groupStarts.push_back( 0 );
+
+    uint32_t lastGoal = kNoField;
+    uint32_t lastGroup = 0;
+    for ( size_t index = 0; index < count; index++ ) {
+        grid::Coord coord;
+        coord.x = streams.pos[ index ].x;
+        coord.y = streams.pos[ index ].y;
 
-        case 0b1100:
-            out = glm::vec2{ 1, 0 };
-            break;
-        case 0b0011:
-            out = glm::vec2{ 0, 1 };
-            break;
-        case 0b1110:
-            out = glm::vec2{ 1, 0 };
-            break;
-        case 0b0111:
-            out = glm::vec2{ 0, 1 };
-            break;
+        grid::Coord goal;
+        goal.x = target[ index ].x;
+        goal.y = target[ index ].y;
 
-        case 0b1101:
-            out = glm::vec2{ 1, 0 };
-            break;
-        case 0b1011:
-            out = glm::vec2{ 0, 1 };
-            break;
-        case 0b1111:
-            out = glm::vec2{ 1, 0 };
-            break;
-        default:
-            // ERROR_LOG() << "WTF: " << (int) v << std::endl;
-            break;
+        uint32_t goalCell = kNoField;
+        if ( grid::contains( gridInfo, coord ) &&
+             grid::contains( gridInfo, goal ) ) {
+            goalCell = grid::index( gridInfo, goal );
         }
 
-        float randAngle = ( rand() % 4 ) * 0.25f * 6.28f;
-        glm::vec2 randVec{ cos( randAngle ), sin( randAngle ) };
+        // crowds mostly share targets
+        if ( goalCell != lastGoal && goalCell != kNoField ) {
+            size_t slot = uint32_t( goalCell * 2654435761u ) >> slotShift;
+            while ( slotGoals[ slot ] != kNoField &&
+                    slotGoals[ slot ] != goalCell ) {
+                slot = ( slot + 1 ) & ( slotCount - 1 );
+            }
 
-        out += randVec * 0.5f;
+            if ( slotGoals[ slot ] == kNoField ) {
+                slotGoals[ slot ] = goalCell;
+                slotGroups[ slot ] = groupGoals.size();
+                groupGoals.push_back( goalCell );
+                groupStarts.push_back( 0 );
+            }
 
-        pathVel.push_back( out );
+            lastGroup = slotGroups[ slot ];
+        } else if ( goalCell == kNoField ) {
+            lastGroup = 0;
+        }
+        lastGoal = goalCell;
+
+        humanGroups.push_back( lastGroup );
+    }
+
+    // groups whose field is already built go first, so with more goals than
+    // the manager holds only the rest have their fields rebuilt
+    size_t groupCount = groupGoals.size();
+    frameArena::List< uint32_t > groupRanks =
+        frameArena::makeList< uint32_t >( arena, groupCount );
+    groupRanks.resize( groupCount );
+
+    size_t rank = 0;
+    for ( int pass = 0; pass < 2; pass++ ) {
+        for ( size_t group = 0; group < groupCount; group++ ) {
+            uint32_t goalCell = groupGoals[ group ];
+            bool first = goalCell == kNoField ||
+                         flowFields::cached(
+                             fields, grid::coord( gridInfo, goalCell ) );
+            if ( first == ( pass == 0 ) ) {
+                groupRanks[ group ] = rank++;
+            }
+        }
+    }
+
+    frameArena::List< uint32_t > rankGoals =
+        frameArena::makeList< uint32_t >( arena, groupCount );
+    rankGoals.resize( groupCount );
+    for ( size_t group = 0; group < groupCount; group++ ) {
+        rankGoals[ groupRanks[ group ] ] = groupGoals[ group ];
+    }
+
+    // counting sort by rank, a group's humans stay in index order
+    for ( size_t index = 0; index < count; index++ ) {
+        groupStarts[ groupRanks[ humanGroups[ index ] ] + 1 ]++;
+    }
+    for ( size_t group = 0; group < groupCount; group++ ) {
+        groupStarts[ group + 1 ] += groupStarts[ group ];
+    }
+
+    frameArena::List< uint32_t > cursors =
+        frameArena::makeList< uint32_t >( arena, groupCount );
+    frameArena::List< uint32_t > order =
+        frameArena::makeList< uint32_t >( arena, count );
+    cursors.resize( groupCount );
+    order.resize( count );
+    std::copy( groupStarts.begin(), groupStarts.begin() + groupCount,
+               cursors.begin() );
+    for ( size_t index = 0; index < count; index++ ) {
+        order[ cursors[ groupRanks[ humanGroups[ index ] ] ]++ ] = index;
     }
 
     ////////////////////////////////////////////////////////////////////////////
-    // move humans forward
+    // bucket humans where they stand and push them apart
     ////////////////////////////////////////////////////////////////////////////
-    for ( index_t index = 0; index < pos.size(); index++ ) {
-        vel[ index ] += pathVel[ index ] * 1000.0f * deltaTime;
-        float len = glm::length( vel[ index ] );
+    if ( state.tycoon.separateHumans ) {
+        spatialHash::build( sim.customerHash, gridInfo, kSeparationRadius,
+                            streams.pos.data(), count );
 
-        if ( len > 100.0f ) {
-            vel[ index ] *= 100.0f / len;
-        }
+        forEachChunk( count, [ & ]( size_t begin, size_t end ) {
+            separateHumans( sim.customerHash, streams, begin, end );
+        } );
     }
 
     ////////////////////////////////////////////////////////////////////////////
-    // move humans forward
+    // steer humans a run of groups at a time, as many groups as the field
+    // manager holds fields. Finding a group's field can then only evict a
+    // field of an earlier run, whose humans are done steering.
     ////////////////////////////////////////////////////////////////////////////
-    for ( index_t index = 0; index < pos.size(); index++ ) {
-        float len = glm::length( vel[ index ] );
-        if ( len > 0 ) {
-            glm::vec2 newPos = pos[ index ] + vel[ index ] * step / len;
+    streams.fieldIndex.resize( count );
 
-            grid::Coord coord;
-            coord.x = newPos.x;
-            coord.y = newPos.y;
+    for ( size_t firstGroup = 0; firstGroup < groupCount; ) {
+        size_t endGroup = firstGroup;
+        size_t runFields = 0;
 
-            grid::Info & gridInfo = state.tycoon.collisionGridInfo;
-            if ( grid::contains( gridInfo, coord ) ) {
-                size_t gridIndex = grid::index( gridInfo, coord );
+        for ( ; endGroup < groupCount; endGroup++ ) {
+            uint32_t goalCell = rankGoals[ endGroup ];
+            uint32_t field = kNoField;
 
-                if ( !state.tycoon.collisionGridData[ gridIndex ] ) {
-                    pos[ index ] = newPos;
+            if ( goalCell != kNoField ) {
+                if ( runFields > 0 && runFields >= fields.capacity ) {
+                    break;
                 }
+
+                field = flowFields::find( fields, gridInfo,
+                                          state.tycoon.collisionGridData,
+                                          grid::coord( gridInfo, goalCell ) );
+                runFields++;
+            }
+
+            for ( size_t i = groupStarts[ endGroup ];
+                  i < groupStarts[ endGroup + 1 ]; i++ ) {
+                streams.fieldIndex[ order[ i ] ] = field;
             }
         }
+
+        size_t first = groupStarts[ firstGroup ];
+        size_t last = groupStarts[ endGroup ];
+        forEachChunk( last - first, [ & ]( size_t begin, size_t end ) {
+            steerHumans( state, streams, order.items + first, begin, end );
+        } );
+
+        firstGroup = endGroup;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    // move humans, chunks spread over the worker pool
+    ////////////////////////////////////////////////////////////////////////////
+    forEachChunk( count, [ & ]( size_t begin, size_t end ) {
+        moveHumans( state, streams, begin, end );
+    } );
+
+    ////////////////////////////////////////////////////////////////////////////
+    // select humans at target
+    ////////////////////////////////////////////////////////////////////////////
+    for ( size_t index = 0; index < count; index++ ) {
+        if ( streams.atTarget[ index ] ) {
+            stoppedAtTargetId.push_back( id[ index ] );
+        }
     }
 }
 
@@ -873,9 +1479,7 @@ static void tickHumans( state::GameState & state ) {
 
     tickHumanAi( state );
 
-    for ( state::id_t id : sim.customersAtTarget ) {
-        removeHuman( state, id );
-    }
+    removeHumans( state, sim.customersAtTarget );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -895,7 +1499,7 @@ static void generateWallRect( state::GameState & state, int x, int y, int width,
         rect.y = top;
         rect.w = wallLength;
         rect.h = wallWidth;
-        state.tycoon.walls.push_back( rect );
+        addWall( state, rect );
     }
 
     // draw bottom
@@ -905,7 +1509,7 @@ static void generateWallRect( state::GameState & state, int x, int y, int width,
         rect.y = top + wallLength * height + wallWidth;
         rect.w = wallLength;
         rect.h = wallWidth;
-        state.tycoon.walls.push_back( rect );
+        addWall( state, rect );
     }
 
     // draw left
@@ -915,7 +1519,7 @@ static void generateWallRect( state::GameState & state, int x, int y, int width,
         rect.y = top + wallLength * i + wallWidth;
         rect.w = wallWidth;
         rect.h = wallLength;
-        state.tycoon.walls.push_back( rect );
+        addWall( state, rect );
     }
 
     // draw right
@@ -925,7 +1529,7 @@ static void generateWallRect( state::GameState & state, int x, int y, int width,
         rect.y = top + wallLength * i + wallWidth;
         rect.w = wallWidth;
         rect.h = wallLength;
-        state.tycoon.walls.push_back( rect );
+        addWall( state, rect );
     }
 }
 
@@ -973,10 +1577,9 @@ static Rect handRect( state::GameState & state, const glm::vec2 & pos ) {
 ////////////////////////////////////////////////////////////////////////////////
 
 static void computePath( state::GameState & state ) {
-    // build collision grid
-    grid::Info gridInfo;
-    gridInfo.width = state.rendering.subRenderWidth;
-    gridInfo.height = state.rendering.subRenderHeight;
+    // uses the collision grid, computeCollisionGrid keeps it current
+    grid::Info gridInfo = state.tycoon.collisionGridInfo;
+    const grid::Bitmap & grid = state.tycoon.collisionGridData;
 
     grid::Coord start;
     grid::Coord end;
@@ -994,26 +1597,28 @@ static void computePath( state::GameState & state ) {
         return;
     }
 
-    size_t gridSize = gridInfo.width * gridInfo.height;
-    std::vector< int > grid( gridSize, 0 );
-
-    for ( Rect wall : state.tycoon.walls ) {
-        wall = math::marginRect( wall, -1 );
-
-        for ( int i = 0; i < wall.w; i++ ) {
-            for ( int j = 0; j < wall.h; j++ ) {
-                int x = wall.x + i;
-                int y = wall.y + j;
+    // repair the previous search, a new goal needs a fresh one
+    dstar::Planner & planner = state.tycoon.waypointPlanner;
+    if ( !planner.initialized || planner.goal.x != end.x ||
+         planner.goal.y != end.y ) {
+        dstar::init( planner, gridInfo, start, end );
+    } else if ( planner.start.x != start.x || planner.start.y != start.y ) {
+        dstar::moveStart( planner, start );
+    }
 
-                if ( grid::contains( gridInfo, x, y ) ) {
-                    auto index = grid::index( gridInfo, x, y );
-                    grid[ index ] = 1;
-                }
-            }
-        }
+    if ( dstar::computeShortestPath( planner, grid ) &&
+         dstar::extractPath( planner, grid, state.tycoon.waypoints ) ) {
+        astar::smoothPath( state.tycoon.tycoonSim.searchContext, grid,
+                           state.tycoon.waypoints );
+        state.tycoon.debugPoints.clear();
+        return;
     }
 
-    auto path = astar::shortestPath( gridInfo, grid, start, end, 1000 );
+    // endpoints inside walls, fall back to a capped search
+    astar::Path path;
+    path.captureOpenPoints = true;
+    astar::shortestPath( state.tycoon.tycoonSim.searchContext, gridInfo, grid,
+                         start, end, 1000, path, astar::kSearchJumpPoint );
 
     // auto vec2Path = toVec2Vector( path.points );
 
@@ -1059,12 +1664,12 @@ static void handleClick( state::GameState & state, glm::vec2 pos ) {
         Rect wallRect = handRect( state, state.tycoon.mousePosition );
 
         if ( !collidesWithWalls( state, wallRect ) ) {
-            state.tycoon.walls.push_back( wallRect );
+            addWall( state, wallRect );
+            updateCollisionRegion( state, wallRect );
         }
 
         state.tycoon.money -= 5;
 
-        computeCollisionGrid( state );
         computePath( state );
     } else if ( state.tycoon.selectedTool == state::TOOL_HUMAN ) {
 
@@ -1086,15 +1691,16 @@ static void handleClick( state::GameState & state, glm::vec2 pos ) {
         }
 
     } else if ( state.tycoon.selectedTool == state::TOOL_ERASE ) {
-        for ( int i = 0; i < std::ssize( state.tycoon.walls ); i++ ) {
-            if ( math::contains( state.tycoon.walls[ i ],
-                                 state.tycoon.mousePosition.x,
-                                 state.tycoon.mousePosition.y ) ) {
-                // remove wall
-                state.tycoon.walls.erase( state.tycoon.walls.begin() + i );
-            }
+        std::vector< int > hits;
+        rectIndex::query( state.tycoon.wallIndex, cursorRect( state ), hits );
+
+        // removal moves the last wall, so remove from the back
+        std::sort( hits.begin(), hits.end(), std::greater< int >() );
+        for ( int i : hits ) {
+            Rect wall = state.tycoon.walls[ i ];
+            removeWall( state, i );
+            updateCollisionRegion( state, wall );
         }
-        computeCollisionGrid( state );
         computePath( state );
     } else if ( state.tycoon.selectedTool == 4 ) {
         // int n = state.tycoon.waypointNum;
@@ -1417,8 +2023,6 @@ void tick( state::GameState & state ) {
                           glm::vec2{ 0.0f, 0.0f }, 1.0f );
 
     tickHumans( state );
-
-    iteratePathGrids( state );
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -1590,10 +2194,11 @@ void render( state::GameState & state ) {
         gfx::setUniform( shader.uUseTexture, 0 );
         gfx::setUniform( shader.uTexture, 0 );
 
-        // draw cost map
-        {
-
-            std::vector< int > & costs = state.tycoon.pathGridCosts;
+        // draw cost map of the last used flow field
+        if ( !state.tycoon.flowFields.fields.empty() ) {
+            flowFields::Manager & fields = state.tycoon.flowFields;
+            std::vector< pathGrid::Cost > & costs =
+                fields.fields[ fields.lastIndex ].costs;
             grid::Info & gridInfo = state.tycoon.collisionGridInfo;
             for ( size_t i = 0; i < grid::size( gridInfo ); i++ ) {
                 int cost = costs[ i ];
@@ -1617,7 +2222,15 @@ void render( state::GameState & state ) {
         }
 
         {
-            for ( auto & wall : state.tycoon.walls ) {
+            // walls under the cursor are highlighted while erasing
+            std::vector< int > hovered;
+            if ( state.tycoon.selectedTool == state::TOOL_ERASE ) {
+                rectIndex::query( state.tycoon.wallIndex, cursorRect( state ),
+                                  hovered );
+            }
+
+            for ( int i = 0; i < std::ssize( state.tycoon.walls ); i++ ) {
+                Rect wall = state.tycoon.walls[ i ];
                 Rect rect;
 
                 bool editingMode =
@@ -1638,9 +2251,8 @@ void render( state::GameState & state ) {
                     gfx::draw( state.tycoon.topLeftUnitQuad );
                 }
 
-                if ( state.tycoon.selectedTool == state::TOOL_ERASE &&
-                     math::contains( wall, state.tycoon.mousePosition.x,
-                                     state.tycoon.mousePosition.y ) ) {
+                if ( std::find( hovered.begin(), hovered.end(), i ) !=
+                     hovered.end() ) {
                     gfx::setUniform( shader.uTint,
                                      glm::vec4( 1.0f, 0.1f, 0.1f, 1.0f ) );
                 } else {
@@ -1654,7 +2266,8 @@ void render( state::GameState & state ) {
             }
         }
 
-        for ( auto & human : state.tycoon.tycoonSim.customers.position ) {
+        for ( auto & human : soa::column< state::kCustomerPosition >(
+                  state.tycoon.tycoonSim.customers.columns ) ) {
             Rect rect;
             rect.x = human.x;
             rect.y = human.y;
@@ -1886,4 +2499,53 @@ static void tryReloadModule( state::GameState & state ) {
     moduleInitialized = true;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+
+/// Humans on a grid around a center human push it nowhere, and the crowd as a
+/// whole doesn't drift, though every human has more neighbors than it counts
+static void testSeparationSymmetry() {
+    const int side = 5;
+    const float spacing = 0.75f;
+
+    std::vector< glm::vec2 > points;
+    for ( int y = -side / 2; y <= side / 2; y++ ) {
+        for ( int x = -side / 2; x <= side / 2; x++ ) {
+            points.push_back( glm::vec2{ 20.0f + x * spacing,
+                                         20.0f + y * spacing } );
+        }
+    }
+
+    spatialHash::Hash hash;
+    spatialHash::build( hash, grid::Info{ 40, 40 }, kSeparationRadius,
+                        points.data(), points.size() );
+
+    frameArena::Arena arena;
+    MassStreams streams;
+    streams.pushX = frameArena::makeList< float >( arena, points.size() );
+    streams.pushY = frameArena::makeList< float >( arena, points.size() );
+    streams.pushX.resize( points.size() );
+    streams.pushY.resize( points.size() );
+
+    separateHumans( hash, streams, 0, points.size() );
+
+    glm::vec2 drift{ 0, 0 };
+    for ( size_t i = 0; i < points.size(); i++ ) {
+        glm::vec2 push{ streams.pushX[ i ], streams.pushY[ i ] };
+        glm::vec2 mirrored{ streams.pushX[ points.size() - 1 - i ],
+                            streams.pushY[ points.size() - 1 - i ] };
+
+        LOGGER_ASSERT( glm::length( push + mirrored ) < 1e-4f );
+        drift += push;
+    }
+
+    glm::vec2 center{ streams.pushX[ points.size() / 2 ],
+                      streams.pushY[ points.size() / 2 ] };
+    LOGGER_ASSERT( glm::length( center ) < 1e-4f );
+    LOGGER_ASSERT( glm::length( drift ) < 1e-3f );
+}
+
+void runTests() {
+    testSeparationSymmetry();
+}
+
 } // namespace tycoon
@@ -25,4 +25,6 @@ void input( state::GameState & state, InputEvent e, InputEventData data );
 void tick( state::GameState & state );
 void render( state::GameState & state );
 
+void runTests();
+
 } // namespace tycoon